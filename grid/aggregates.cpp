@@ -0,0 +1,303 @@
+#include "aggregates.h"
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define GRID_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
+//MSVC accepts intrinsics of any instruction set, others require the function to be marked
+#if defined(GRID_X86) && !defined(_MSC_VER)
+	#define GRID_TARGET(isa) __attribute__((target(isa)))
+#else
+	#define GRID_TARGET(isa)
+#endif
+
+
+
+namespace grid
+{
+	/*
+		Partial results of a kernel.
+		Sums are of shifted values (x - m_Shift), m_Sum = m_S1 + m_Count * m_Shift
+	*/
+	struct Accumulator
+	{
+		double m_Shift{ 0 };
+		size_t m_Count{ 0 };
+		double m_S1{ 0 }, m_C1{ 0 }; //sum and compensation
+		double m_S2{ 0 }, m_C2{ 0 }; //sum of squares and compensation
+		double m_Min{ std::numeric_limits<double>::infinity() };
+		double m_Max{ -std::numeric_limits<double>::infinity() };
+
+		//Neumaier summation
+		static void Add(double& Sum, double& Comp, double Value)
+		{
+			double t = Sum + Value;
+			if (std::abs(Sum) >= std::abs(Value))
+				Comp += (Sum - t) + Value;
+			else
+				Comp += (Value - t) + Sum;
+
+			Sum = t;
+		}
+
+		void AddValue(double x)
+		{
+			if (std::isnan(x))
+				return;
+
+			double y = x - m_Shift;
+
+			m_Count++;
+			Add(m_S1, m_C1, y);
+			Add(m_S2, m_C2, y * y);
+
+			m_Min = std::min(m_Min, x);
+			m_Max = std::max(m_Max, x);
+		}
+	};
+
+
+	using Kernel = void (*)(const double* Values, size_t N, Accumulator& Acc);
+
+
+	static void ScalarKernel(const double* Values, size_t N, Accumulator& Acc)
+	{
+		for (size_t i = 0; i < N; ++i)
+			Acc.AddValue(Values[i]);
+	}
+
+
+#ifdef GRID_X86
+
+	/*
+		Each lane keeps its own Kahan sums, lanes are combined with Neumaier summation.
+		min_pd/max_pd return the second operand if the first one is NaN, therefore NaNs are skipped.
+	*/
+
+	GRID_TARGET("sse2")
+	static void SSE2Kernel(const double* Values, size_t N, Accumulator& Acc)
+	{
+		const __m128d Shift = _mm_set1_pd(Acc.m_Shift);
+		const __m128d One = _mm_set1_pd(1.0);
+
+		__m128d S1 = _mm_setzero_pd(), C1 = _mm_setzero_pd();
+		__m128d S2 = _mm_setzero_pd(), C2 = _mm_setzero_pd();
+		__m128d Count = _mm_setzero_pd();
+		__m128d Min = _mm_set1_pd(Acc.m_Min), Max = _mm_set1_pd(Acc.m_Max);
+
+		size_t i = 0;
+		for (; i + 2 <= N; i += 2)
+		{
+			__m128d x = _mm_loadu_pd(Values + i);
+			__m128d Mask = _mm_cmpord_pd(x, x);
+
+			__m128d y = _mm_and_pd(_mm_sub_pd(x, Shift), Mask);
+			Count = _mm_add_pd(Count, _mm_and_pd(One, Mask));
+
+			__m128d yc = _mm_sub_pd(y, C1);
+			__m128d t = _mm_add_pd(S1, yc);
+			C1 = _mm_sub_pd(_mm_sub_pd(t, S1), yc);
+			S1 = t;
+
+			__m128d sq = _mm_sub_pd(_mm_mul_pd(y, y), C2);
+			t = _mm_add_pd(S2, sq);
+			C2 = _mm_sub_pd(_mm_sub_pd(t, S2), sq);
+			S2 = t;
+
+			Min = _mm_min_pd(x, Min);
+			Max = _mm_max_pd(x, Max);
+		}
+
+		alignas(16) double s1[2], c1[2], s2[2], c2[2], cnt[2], mn[2], mx[2];
+		_mm_store_pd(s1, S1); _mm_store_pd(c1, C1);
+		_mm_store_pd(s2, S2); _mm_store_pd(c2, C2);
+		_mm_store_pd(cnt, Count);
+		_mm_store_pd(mn, Min); _mm_store_pd(mx, Max);
+
+		for (int k = 0; k < 2; ++k)
+		{
+			//Kahan compensation holds the negative error
+			Accumulator::Add(Acc.m_S1, Acc.m_C1, s1[k]);
+			Accumulator::Add(Acc.m_S1, Acc.m_C1, -c1[k]);
+			Accumulator::Add(Acc.m_S2, Acc.m_C2, s2[k]);
+			Accumulator::Add(Acc.m_S2, Acc.m_C2, -c2[k]);
+
+			Acc.m_Count += (size_t)cnt[k];
+			Acc.m_Min = std::min(Acc.m_Min, mn[k]);
+			Acc.m_Max = std::max(Acc.m_Max, mx[k]);
+		}
+
+		ScalarKernel(Values + i, N - i, Acc);
+	}
+
+
+	GRID_TARGET("avx2")
+	static void AVX2Kernel(const double* Values, size_t N, Accumulator& Acc)
+	{
+		const __m256d Shift = _mm256_set1_pd(Acc.m_Shift);
+		const __m256d One = _mm256_set1_pd(1.0);
+
+		__m256d S1 = _mm256_setzero_pd(), C1 = _mm256_setzero_pd();
+		__m256d S2 = _mm256_setzero_pd(), C2 = _mm256_setzero_pd();
+		__m256d Count = _mm256_setzero_pd();
+		__m256d Min = _mm256_set1_pd(Acc.m_Min), Max = _mm256_set1_pd(Acc.m_Max);
+
+		size_t i = 0;
+		for (; i + 4 <= N; i += 4)
+		{
+			__m256d x = _mm256_loadu_pd(Values + i);
+			__m256d Mask = _mm256_cmp_pd(x, x, _CMP_ORD_Q);
+
+			__m256d y = _mm256_and_pd(_mm256_sub_pd(x, Shift), Mask);
+			Count = _mm256_add_pd(Count, _mm256_and_pd(One, Mask));
+
+			__m256d yc = _mm256_sub_pd(y, C1);
+			__m256d t = _mm256_add_pd(S1, yc);
+			C1 = _mm256_sub_pd(_mm256_sub_pd(t, S1), yc);
+			S1 = t;
+
+			__m256d sq = _mm256_sub_pd(_mm256_mul_pd(y, y), C2);
+			t = _mm256_add_pd(S2, sq);
+			C2 = _mm256_sub_pd(_mm256_sub_pd(t, S2), sq);
+			S2 = t;
+
+			Min = _mm256_min_pd(x, Min);
+			Max = _mm256_max_pd(x, Max);
+		}
+
+		alignas(32) double s1[4], c1[4], s2[4], c2[4], cnt[4], mn[4], mx[4];
+		_mm256_store_pd(s1, S1); _mm256_store_pd(c1, C1);
+		_mm256_store_pd(s2, S2); _mm256_store_pd(c2, C2);
+		_mm256_store_pd(cnt, Count);
+		_mm256_store_pd(mn, Min); _mm256_store_pd(mx, Max);
+
+		for (int k = 0; k < 4; ++k)
+		{
+			Accumulator::Add(Acc.m_S1, Acc.m_C1, s1[k]);
+			Accumulator::Add(Acc.m_S1, Acc.m_C1, -c1[k]);
+			Accumulator::Add(Acc.m_S2, Acc.m_C2, s2[k]);
+			Accumulator::Add(Acc.m_S2, Acc.m_C2, -c2[k]);
+
+			Acc.m_Count += (size_t)cnt[k];
+			Acc.m_Min = std::min(Acc.m_Min, mn[k]);
+			Acc.m_Max = std::max(Acc.m_Max, mx[k]);
+		}
+
+		ScalarKernel(Values + i, N - i, Acc);
+	}
+
+
+	static bool SupportsAVX2()
+	{
+#ifdef _MSC_VER
+		int Info[4];
+		__cpuid(Info, 0);
+		if (Info[0] < 7)
+			return false;
+
+		__cpuid(Info, 1);
+		bool OSXSave = (Info[2] & (1 << 27)) != 0;
+		bool AVX = (Info[2] & (1 << 28)) != 0;
+
+		//OS must save the YMM registers
+		if (!OSXSave || !AVX || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+
+		__cpuidex(Info, 7, 0);
+		return (Info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+#endif //GRID_X86
+
+
+	static Kernel SelectKernel()
+	{
+#ifdef GRID_X86
+		if (SupportsAVX2())
+			return AVX2Kernel;
+
+		return SSE2Kernel;
+#else
+		return ScalarKernel;
+#endif
+	}
+
+
+
+
+	void Stats::Merge(const Stats& Other)
+	{
+		if (Other.m_Count == 0)
+			return;
+
+		if (m_Count == 0)
+		{
+			*this = Other;
+			return;
+		}
+
+		double n1 = (double)m_Count, n2 = (double)Other.m_Count;
+		double n = n1 + n2;
+
+		//Chan et al. parallel algorithm
+		double M2_1 = m_Count > 1 ? m_Var * (n1 - 1) : 0.0;
+		double M2_2 = Other.m_Count > 1 ? Other.m_Var * (n2 - 1) : 0.0;
+		double Delta = Other.m_Mean - m_Mean;
+
+		double M2 = M2_1 + M2_2 + Delta * Delta * n1 * n2 / n;
+
+		m_Count += Other.m_Count;
+		m_Sum += Other.m_Sum;
+		m_Mean += Delta * n2 / n;
+		m_Min = std::min(m_Min, Other.m_Min);
+		m_Max = std::max(m_Max, Other.m_Max);
+		m_Var = M2 / (n - 1);
+	}
+
+
+	Stats ComputeStats(std::span<const double> Values)
+	{
+		static const Kernel kernel = SelectKernel();
+
+		Stats Result;
+
+		//shifting by a value from the data avoids cancellation in the variance
+		auto First = std::find_if(Values.begin(), Values.end(), [](double x) { return !std::isnan(x); });
+		if (First == Values.end())
+			return Result;
+
+		Accumulator Acc;
+		Acc.m_Shift = *First;
+
+		size_t Offset = First - Values.begin();
+		kernel(Values.data() + Offset, Values.size() - Offset, Acc);
+
+		if (Acc.m_Count == 0)
+			return Result;
+
+		double n = (double)Acc.m_Count;
+		double S1 = Acc.m_S1 + Acc.m_C1;
+		double S2 = Acc.m_S2 + Acc.m_C2;
+
+		Result.m_Count = Acc.m_Count;
+		Result.m_Sum = S1 + n * Acc.m_Shift;
+		Result.m_Mean = Acc.m_Shift + S1 / n;
+		Result.m_Min = Acc.m_Min;
+		Result.m_Max = Acc.m_Max;
+
+		if (Acc.m_Count > 1)
+			Result.m_Var = std::max(0.0, (S2 - S1 * S1 / n) / (n - 1));
+
+		return Result;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <span>
+#include <limits>
+#include <cstddef>
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	//NaN values (empty or non-numeric cells) are not counted
+	struct DLLGRID Stats
+	{
+		size_t m_Count{ 0 }; //number of numeric values
+		double m_Sum{ 0 };
+		double m_Mean{ std::numeric_limits<double>::quiet_NaN() };
+		double m_Min{ std::numeric_limits<double>::quiet_NaN() };
+		double m_Max{ std::numeric_limits<double>::quiet_NaN() };
+		double m_Var{ std::numeric_limits<double>::quiet_NaN() }; //sample variance
+
+		//combines the stats of two disjoint sets of values
+		void Merge(const Stats& Other);
+	};
+
+
+	/*
+		Single pass over Values with compensated sums (variance is computed on shifted values).
+		Uses AVX2 or SSE2 kernels when the processor supports them, otherwise scalar code.
+	*/
+	DLLGRID Stats ComputeStats(std::span<const double> Values);
+}
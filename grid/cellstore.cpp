@@ -0,0 +1,155 @@
+#include "cellstore.h"
+
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <sstream>
+
+#include <wx/utils.h>
+
+#include "ws_funcs.h"
+#include "workbookbase.h"
+
+
+
+namespace grid
+{
+	size_t CellsMemorySize(const std::vector<Cell>& Cells)
+	{
+		size_t Size = Cells.capacity() * sizeof(Cell);
+		for (const auto& cell : Cells)
+			Size += cell.GetValue().capacity() * sizeof(wchar_t);
+
+		return Size;
+	}
+
+
+
+
+	CellStore::~CellStore()
+	{
+		RemoveFile();
+	}
+
+
+	CellStore::CellStore(CellStore&& rhs) noexcept
+	{
+		m_Cells = std::move(rhs.m_Cells);
+		m_File = std::move(rhs.m_File);
+		m_NCells = rhs.m_NCells;
+
+		rhs.m_File.clear();
+		rhs.m_NCells = 0;
+	}
+
+
+	CellStore& CellStore::operator=(CellStore&& rhs) noexcept
+	{
+		if (this == &rhs)
+			return *this;
+
+		RemoveFile();
+
+		m_Cells = std::move(rhs.m_Cells);
+		m_File = std::move(rhs.m_File);
+		m_NCells = rhs.m_NCells;
+
+		rhs.m_File.clear();
+		rhs.m_NCells = 0;
+
+		return *this;
+	}
+
+
+	void CellStore::Store(
+		std::vector<Cell>&& Cells,
+		const std::filesystem::path& SpillDir,
+		size_t Threshold)
+	{
+		RemoveFile();
+
+		m_NCells = Cells.size();
+
+		if (SpillDir.empty() || CellsMemorySize(Cells) <= Threshold)
+		{
+			m_Cells = std::move(Cells);
+			return;
+		}
+
+		std::error_code ec;
+		std::filesystem::create_directories(SpillDir, ec);
+
+		//unique among the processes sharing the directory
+		static std::atomic<size_t> FileNumber{ 0 };
+		auto FilePath = SpillDir / std::format("undo_{}_{}.bin", wxGetProcessId(), ++FileNumber);
+
+		std::string Data = GenerateBinaryData(Cells, true);
+
+		std::ofstream file(FilePath, std::ios::binary | std::ios::trunc);
+		if (!ec && file && file.write(Data.data(), Data.size()))
+		{
+			m_File = FilePath;
+			m_Cells.clear();
+			m_Cells.shrink_to_fit();
+			
+			return;
+		}
+
+		//could not spill, keep in memory
+		file.close();
+		std::filesystem::remove(FilePath, ec);
+
+		m_Cells = std::move(Cells);
+	}
+
+
+	void CellStore::Store(
+		std::vector<Cell>&& Cells,
+		const CWorkbookBase* workbook)
+	{
+		if (!workbook)
+			Store(std::move(Cells), std::filesystem::path(), 0);
+		else
+			Store(std::move(Cells), workbook->GetSpillDirectory(), workbook->GetSpillThreshold());
+	}
+
+
+	std::vector<Cell> CellStore::Load() const
+	{
+		if (!IsSpilled())
+			return m_Cells;
+
+		std::ifstream file(m_File, std::ios::binary);
+		if (!file)
+			throw std::exception("Undo data file cannot be opened.");
+
+		std::stringstream Data;
+		Data << file.rdbuf();
+
+		const std::string& Str = Data.str();
+
+		auto Cells = BinaryDataToCells(Str.data(), Str.size());
+		if (Cells.size() != m_NCells)
+			throw std::exception("Undo data file is corrupted.");
+
+		return Cells;
+	}
+
+
+	size_t CellStore::GetMemorySize() const
+	{
+		return sizeof(*this) + CellsMemorySize(m_Cells) + m_File.native().capacity() * sizeof(m_File.native()[0]);
+	}
+
+
+	void CellStore::RemoveFile()
+	{
+		if (m_File.empty())
+			return;
+
+		std::error_code ec;
+		std::filesystem::remove(m_File, ec);
+
+		m_File.clear();
+	}
+}
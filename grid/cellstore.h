@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+
+#include "ws_cell.h"
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	class CWorkbookBase;
+
+	//approximate memory held by a vector of cells
+	DLLGRID size_t CellsMemorySize(const std::vector<Cell>& Cells);
+
+
+	/*
+		Holds cells either in memory or, if they are large, compressed in a file (spilled).
+		Spilled cells are only read back when Load is called.
+	*/
+	class DLLGRID CellStore
+	{
+	public:
+		CellStore() = default;
+		~CellStore();
+
+		CellStore(const CellStore&) = delete;
+		CellStore& operator=(const CellStore&) = delete;
+
+		CellStore(CellStore&& rhs) noexcept;
+		CellStore& operator=(CellStore&& rhs) noexcept;
+
+		//Spills the cells into SpillDir if they need more than Threshold bytes (if SpillDir is empty, never spills)
+		void Store(
+			std::vector<Cell>&& Cells,
+			const std::filesystem::path& SpillDir,
+			size_t Threshold);
+
+		//uses the spill settings of the workbook (if workbook is null, keeps in memory)
+		void Store(
+			std::vector<Cell>&& Cells,
+			const CWorkbookBase* workbook);
+
+		//throws std::exception if the spilled cells cannot be read back
+		std::vector<Cell> Load() const;
+
+		bool IsSpilled() const {
+			return !m_File.empty();
+		}
+
+		//number of cells
+		size_t size() const {
+			return m_NCells;
+		}
+
+		//resident memory
+		size_t GetMemorySize() const;
+
+	private:
+		void RemoveFile();
+
+	private:
+		std::vector<Cell> m_Cells;
+		std::filesystem::path m_File;
+		size_t m_NCells{ 0 };
+	};
+}
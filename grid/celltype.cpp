@@ -0,0 +1,178 @@
+#include "celltype.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+#include "narrowcells.h"
+
+
+namespace grid
+{
+	//reads between MinN and MaxN digits
+	static bool ReadDigits(const char*& p, const char* End, int MinN, int MaxN, int& Value)
+	{
+		int N = 0;
+		Value = 0;
+		while (p < End && N < MaxN && std::isdigit((unsigned char)*p))
+		{
+			Value = Value * 10 + (*p - '0');
+			++p;
+			++N;
+		}
+
+		return N >= MinN && (p == End || !std::isdigit((unsigned char)*p));
+	}
+
+
+	static bool IsTime(const char* p, const char* End)
+	{
+		int Hour{}, Minute{}, Second{};
+		if (!ReadDigits(p, End, 1, 2, Hour) || Hour > 23)
+			return false;
+
+		if (p == End || *p++ != ':' || !ReadDigits(p, End, 2, 2, Minute) || Minute > 59)
+			return false;
+
+		if (p < End && *p == ':')
+		{
+			++p;
+			if (!ReadDigits(p, End, 2, 2, Second) || Second > 59)
+				return false;
+
+			//fractions of a second
+			if (p < End && *p == '.')
+			{
+				++p;
+				int Fraction{};
+				if (!ReadDigits(p, End, 1, 9, Fraction))
+					return false;
+			}
+		}
+
+		return p == End;
+	}
+
+
+	static bool IsDate(const char* p, const char* End)
+	{
+		int a{}, b{}, c{};
+
+		const char* First = p;
+		if (!ReadDigits(p, End, 1, 4, a) || p == End)
+			return false;
+
+		bool YearFirst = p - First == 4;
+
+		char Sep = *p++;
+		if (Sep != '-' && Sep != '/' && Sep != '.')
+			return false;
+
+		if (!ReadDigits(p, End, 1, 2, b) || p == End || *p++ != Sep)
+			return false;
+
+		const char* Third = p;
+		if (!ReadDigits(p, End, 1, 4, c))
+			return false;
+
+		bool YearLast = p - Third == 4;
+
+		if (YearFirst == YearLast)
+			return false;
+
+		if (YearFirst)
+		{
+			if (b < 1 || b > 12 || c < 1 || c > 31)
+				return false;
+		}
+		else
+		{
+			//day and month can be in either order
+			bool DayMonth = a >= 1 && a <= 31 && b >= 1 && b <= 12;
+			bool MonthDay = a >= 1 && a <= 12 && b >= 1 && b <= 31;
+			if (!DayMonth && !MonthDay)
+				return false;
+		}
+
+		if (p == End)
+			return true;
+
+		if (*p != ' ' && *p != 'T')
+			return false;
+
+		return IsTime(p + 1, End);
+	}
+
+
+	static bool IsBoolean(const char* Begin, const char* End)
+	{
+		auto Equals = [&](const char* Word)
+		{
+			size_t N = std::strlen(Word);
+			if ((size_t)(End - Begin) != N)
+				return false;
+
+			for (size_t i = 0; i < N; ++i)
+				if (std::tolower((unsigned char)Begin[i]) != Word[i])
+					return false;
+
+			return true;
+		};
+
+		return Equals("true") || Equals("false");
+	}
+
+
+
+
+	CELLTYPE ClassifyCell(const char* Begin, const char* End)
+	{
+		while (Begin < End && std::isspace((unsigned char)*Begin))
+			++Begin;
+
+		while (End > Begin && std::isspace((unsigned char)*(End - 1)))
+			--End;
+
+		if (Begin == End)
+			return CELLTYPE::EMPTY;
+
+		char First = *Begin, Last = *(End - 1);
+
+		//only the checks that can succeed are done (inf and nan are text)
+		bool NumericEnd = std::isdigit((unsigned char)Last) || Last == '.';
+		if (NumericEnd && (std::isdigit((unsigned char)First) || First == '+' || First == '-' || First == '.'))
+		{
+			std::int64_t Int{};
+			if (ParseNumber(Begin, End, Int))
+				return CELLTYPE::INTEGER;
+
+			double Float{};
+			if (ParseNumber(Begin, End, Float))
+				return CELLTYPE::FLOAT;
+
+			if (std::isdigit((unsigned char)First) && IsDate(Begin, End))
+				return CELLTYPE::DATE;
+
+			return CELLTYPE::TEXT;
+		}
+
+		if (IsBoolean(Begin, End))
+			return CELLTYPE::BOOLEAN;
+
+		return CELLTYPE::TEXT;
+	}
+
+
+	const wchar_t* TypeName(CELLTYPE Type)
+	{
+		switch (Type)
+		{
+		case CELLTYPE::EMPTY: return L"empty";
+		case CELLTYPE::BOOLEAN: return L"boolean";
+		case CELLTYPE::INTEGER: return L"integer";
+		case CELLTYPE::FLOAT: return L"float";
+		case CELLTYPE::DATE: return L"date";
+		default: return L"text";
+		}
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	enum class CELLTYPE { EMPTY = 0, BOOLEAN, INTEGER, FLOAT, DATE, TEXT };
+
+
+	/*
+		Type of the narrow characters [Begin, End), surrounding whitespace is ignored.
+		Booleans are true/false (any case), dates are Y-M-D or D-M-Y (also M-D-Y) with -, / or .
+		and an optional hh:mm[:ss] time.
+	*/
+	DLLGRID CELLTYPE ClassifyCell(const char* Begin, const char* End);
+
+
+	//type of a column holding cells of both types
+	inline CELLTYPE WidenType(CELLTYPE a, CELLTYPE b)
+	{
+		if (a == b || b == CELLTYPE::EMPTY)
+			return a;
+
+		if (a == CELLTYPE::EMPTY)
+			return b;
+
+		if ((a == CELLTYPE::INTEGER && b == CELLTYPE::FLOAT) || (a == CELLTYPE::FLOAT && b == CELLTYPE::INTEGER))
+			return CELLTYPE::FLOAT;
+
+		return CELLTYPE::TEXT;
+	}
+
+
+	DLLGRID const wchar_t* TypeName(CELLTYPE Type);
+}
@@ -0,0 +1,148 @@
+#include "fill.h"
+
+#include <cmath>
+#include <chrono>
+#include <cctype>
+#include <charconv>
+#include <algorithm>
+
+#include "narrowcells.h"
+#include "parallel.h"
+
+
+namespace grid
+{
+	using namespace std::chrono;
+
+
+	//Y-M-D with a 4 digit year, Sep receives the separator
+	static bool ParseDate(const char* Begin, const char* End, year_month_day& Date, char& Sep)
+	{
+		int y{}, m{}, d{};
+
+		auto [YEnd, YErr] = std::from_chars(Begin, End, y);
+		if (YErr != std::errc() || YEnd - Begin != 4 || YEnd == End)
+			return false;
+
+		Sep = *YEnd;
+		if (Sep != '-' && Sep != '/')
+			return false;
+
+		auto [MEnd, MErr] = std::from_chars(YEnd + 1, End, m);
+		if (MErr != std::errc() || MEnd == End || *MEnd != Sep || m < 1)
+			return false;
+
+		auto [DEnd, DErr] = std::from_chars(MEnd + 1, End, d);
+		if (DErr != std::errc() || DEnd != End || d < 1)
+			return false;
+
+		Date = year{ y } / month{ (unsigned)m } / day{ (unsigned)d };
+
+		return Date.ok();
+	}
+
+
+	static wxString FormatDate(const year_month_day& Date, char Sep)
+	{
+		char Buffer[32];
+		char* p = Buffer;
+
+		//zero padded to Width digits
+		auto Put = [&](int Value, int Width)
+		{
+			char Digits[12];
+			auto [DigitsEnd, ErrCode] = std::to_chars(Digits, Digits + sizeof(Digits), Value);
+
+			for (auto n = DigitsEnd - Digits; n < Width; ++n)
+				*p++ = '0';
+
+			p = std::copy(Digits, DigitsEnd, p);
+		};
+
+		Put((int)Date.year(), 4);
+		*p++ = Sep;
+		Put((int)(unsigned)Date.month(), 2);
+		*p++ = Sep;
+		Put((int)(unsigned)Date.day(), 2);
+
+		return wxString(Buffer, p - Buffer);
+	}
+
+
+	static year_month_day AddDate(const year_month_day& Start, long long N, DATEUNIT Unit)
+	{
+		if (Unit == DATEUNIT::DAY)
+			return year_month_day(sys_days(Start) + days(N));
+
+		year_month YM(Start.year(), Start.month());
+		YM = Unit == DATEUNIT::MONTH ? YM + months(N) : YM + years(N);
+
+		//Jan 31 + 1 month is the last day of February
+		auto LastDay = year_month_day_last(YM.year(), month_day_last(YM.month())).day();
+
+		return year_month_day(YM.year(), YM.month(), std::min(Start.day(), LastDay));
+	}
+
+
+
+
+	bool GenerateSeries(
+		const wxString& Start,
+		const FillGenerator& Gen,
+		std::span<wxString> Values)
+	{
+		if (!Gen.IsSeries())
+			return false;
+
+		NarrowCells Cells;
+		Cells.Append(Start);
+		Cells.Close();
+
+		const char* Begin = Cells.begin(0), *End = Cells.end(0);
+
+		while (Begin < End && std::isspace((unsigned char)*Begin))
+			++Begin;
+
+		while (End > Begin && std::isspace((unsigned char)*(End - 1)))
+			--End;
+
+		if (Gen.m_Fill == FILL::DATE)
+		{
+			year_month_day Date;
+			char Sep{};
+			if (!ParseDate(Begin, End, Date, Sep))
+				return false;
+
+			ParallelFor(Values.size(), [&](size_t First, size_t Last)
+			{
+				for (size_t i = First; i < Last; ++i)
+				{
+					auto N = std::llround(Gen.m_Step * (double)(i + 1));
+					Values[i] = FormatDate(AddDate(Date, N, Gen.m_Unit), Sep);
+				}
+			}, 16384);
+
+			return true;
+		}
+
+		double Value{};
+		if (!ParseNumber(Begin, End, Value))
+			return false;
+
+		bool Growth = Gen.m_Fill == FILL::GROWTH;
+
+		ParallelFor(Values.size(), [&](size_t First, size_t Last)
+		{
+			for (size_t i = First; i < Last; ++i)
+			{
+				double n = (double)(i + 1);
+				double Term = Growth ? Value * std::pow(Gen.m_Step, n) : Value + Gen.m_Step * n;
+
+				//15 significant digits, so that 0.1 + 2 * 0.1 is written as 0.3
+				Values[i] = FormatNumber(Term, 15);
+			}
+		}, 16384);
+
+		return true;
+	}
+}
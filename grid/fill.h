@@ -0,0 +1,48 @@
+#pragma once
+
+#include <span>
+
+#include <wx/string.h>
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	enum class FILL { DOWN = 0, RIGHT, LINEAR, GROWTH, DATE };
+	enum class DATEUNIT { DAY = 0, MONTH, YEAR };
+
+
+	//how a fill generates a rectangle from its first row (or first column)
+	struct FillGenerator
+	{
+		FILL m_Fill{ FILL::DOWN };
+
+		//series run down the columns, otherwise along the rows (DOWN and RIGHT set their own direction)
+		bool m_Down{ true };
+
+		//added (LINEAR), multiplied (GROWTH) or number of m_Units added (DATE)
+		double m_Step{ 1 };
+		DATEUNIT m_Unit{ DATEUNIT::DAY };
+
+		bool IsDown() const {
+			return m_Fill == FILL::DOWN || (m_Fill != FILL::RIGHT && m_Down);
+		}
+
+		bool IsSeries() const {
+			return m_Fill != FILL::DOWN && m_Fill != FILL::RIGHT;
+		}
+	};
+
+
+	/*
+		Values.size() terms of the series following Start (Start itself is not included).
+		Each term is computed from Start, therefore there is no accumulated error.
+		Dates are Y-M-D with - or / and keep the separator, days past the end of a month are clamped.
+		Returns false if Gen is not a series or Start is not a number (a date for FILL::DATE).
+	*/
+	DLLGRID bool GenerateSeries(
+		const wxString& Start,
+		const FillGenerator& Gen,
+		std::span<wxString> Values);
+}
@@ -0,0 +1,248 @@
+#include "findreplace.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <string_view>
+#include <condition_variable>
+
+#include "worksheetbase.h"
+#include "workbookbase.h"
+
+
+wxDEFINE_EVENT(ssEVT_WB_FINDPROGRESS, grid::CFindEvent);
+
+
+namespace grid
+{
+	//rows of a worksheet scanned by one task
+	constexpr int TASKROWS = 4096;
+
+	//interval of the progress events
+	constexpr auto PROGRESSINTERVAL = std::chrono::milliseconds(100);
+
+
+	CMatcher::CMatcher(const FindOptions& Options) :m_Options{ Options }
+	{
+		if (m_Options.m_Regex)
+		{
+			std::wstring Pattern = m_Options.m_Pattern.ToStdWstring();
+			if (m_Options.m_WholeCell)
+				Pattern = L"^(?:" + Pattern + L")$";
+
+			auto Flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+			if (!m_Options.m_MatchCase)
+				Flags |= std::regex_constants::icase;
+
+			m_Regex = std::wregex(Pattern, Flags);
+		}
+		else
+		{
+			m_Literal = m_Options.m_MatchCase ?
+				m_Options.m_Pattern.ToStdWstring() :
+				m_Options.m_Pattern.Lower().ToStdWstring();
+		}
+	}
+
+
+	bool CMatcher::Matches(const wxString& Value) const
+	{
+		if (m_Options.m_Regex)
+		{
+			//a pathological pattern can exceed the complexity limit on some values
+			try {
+				return std::regex_search(Value.wc_str(), Value.wc_str() + Value.length(), m_Regex);
+			}
+			catch (const std::regex_error&) {
+				return false;
+			}
+		}
+
+		if (m_Literal.empty())
+			return false;
+
+		//lowering allocates, only done if case is ignored
+		wxString Lowered = m_Options.m_MatchCase ? wxString() : Value.Lower();
+		const wxString& Str = m_Options.m_MatchCase ? Value : Lowered;
+
+		std::wstring_view View(Str.wc_str(), Str.length());
+
+		if (m_Options.m_WholeCell)
+			return View == m_Literal;
+
+		return View.find(m_Literal) != std::wstring_view::npos;
+	}
+
+
+	wxString CMatcher::Replace(const wxString& Value, const wxString& Replacement) const
+	{
+		if (m_Options.m_Regex)
+		{
+			try {
+				return std::regex_replace(Value.ToStdWstring(), m_Regex, Replacement.ToStdWstring());
+			}
+			catch (const std::regex_error&) {
+				return Value;
+			}
+		}
+
+		if (m_Options.m_WholeCell)
+			return Matches(Value) ? Replacement : Value;
+
+		if (m_Literal.empty())
+			return Value;
+
+		//positions are found in the (lowered) copy, text is taken from the original
+		wxString Lowered = m_Options.m_MatchCase ? wxString() : Value.Lower();
+		const wxString& Str = m_Options.m_MatchCase ? Value : Lowered;
+
+		std::wstring_view View(Str.wc_str(), Str.length());
+
+		wxString Result;
+		size_t Start = 0;
+		for (size_t Pos = View.find(m_Literal); Pos != std::wstring_view::npos; Pos = View.find(m_Literal, Start))
+		{
+			Result << Value.Mid(Start, Pos - Start) << Replacement;
+			Start = Pos + m_Literal.length();
+		}
+
+		Result << Value.Mid(Start);
+
+		return Result;
+	}
+
+
+
+
+	WorkbookMatches ScanWorkbook(
+		CWorkbookBase* Workbook,
+		const CMatcher& Matcher,
+		const wxString* Replacement)
+	{
+		struct Task
+		{
+			size_t m_WSId;
+
+			//copied on the calling thread, workers do not touch the grid
+			std::vector<wxGridCellCoords> m_Coords;
+			std::vector<wxString> m_Values;
+
+			WorkbookMatches m_Result;
+		};
+
+		std::vector<Task> Tasks;
+		size_t Total = 0;
+
+		//tasks are in page order then row order, concatenating their results keeps the order
+		for (size_t i = 0; i < Workbook->size(); ++i)
+		{
+			auto ws = Workbook->GetWorksheet(i);
+			const auto& Content = ws->GetChangedCells_Content();
+			if (Content.empty())
+				continue;
+
+			Total += Content.size();
+
+			auto Table = ws->GetTable();
+
+			int LastRow = Content.rbegin()->GetRow() + 1;
+			for (int Row = Content.begin()->GetRow(); Row < LastRow; Row += TASKROWS)
+			{
+				Task task{ ws->GetWSId() };
+
+				auto End = Content.lower_bound({ std::min(Row + TASKROWS, LastRow), 0 });
+				for (auto it = Content.lower_bound({ Row, 0 }); it != End; ++it)
+				{
+					task.m_Coords.push_back(*it);
+					task.m_Values.push_back(Table->GetValue(it->GetRow(), it->GetCol()));
+				}
+
+				if (!task.m_Coords.empty())
+					Tasks.push_back(std::move(task));
+			}
+		}
+
+		std::atomic<size_t> NextTask{ 0 };
+
+		std::mutex Mutex;
+		std::condition_variable CV;
+		std::vector<FindMatch> Pending;
+		size_t Scanned = 0, NDone = 0;
+
+		auto Work = [&]
+		{
+			for (size_t t = NextTask++; t < Tasks.size(); t = NextTask++)
+			{
+				auto& task = Tasks[t];
+
+				size_t N = task.m_Values.size();
+				for (size_t i = 0; i < N; ++i)
+				{
+					const wxString& Value = task.m_Values[i];
+					if (!Matcher.Matches(Value))
+						continue;
+
+					task.m_Result.m_Matches.push_back({ task.m_WSId, task.m_Coords[i] });
+
+					if (Replacement)
+						task.m_Result.m_NewValues.push_back(Matcher.Replace(Value, *Replacement));
+				}
+
+				{
+					std::lock_guard lock(Mutex);
+					Pending.insert(Pending.end(), task.m_Result.m_Matches.begin(), task.m_Result.m_Matches.end());
+					Scanned += N;
+					NDone++;
+				}
+
+				CV.notify_one();
+			}
+		};
+
+		size_t NThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+		NThreads = std::min(NThreads, Tasks.size());
+
+		std::vector<std::jthread> Threads;
+		for (size_t i = 0; i < NThreads; ++i)
+			Threads.emplace_back(Work);
+
+		bool Done = Tasks.empty();
+		while (!Done)
+		{
+			std::vector<FindMatch> Batch;
+			size_t NScanned = 0;
+
+			{
+				std::unique_lock lock(Mutex);
+				CV.wait_for(lock, PROGRESSINTERVAL, [&] { return NDone == Tasks.size(); });
+
+				Batch.swap(Pending);
+				NScanned = Scanned;
+				Done = NDone == Tasks.size();
+			}
+
+			//handlers must not modify the worksheets
+			CFindEvent evt(ssEVT_WB_FINDPROGRESS, Workbook->GetId(), std::move(Batch), NScanned, Total);
+			evt.SetEventObject(Workbook);
+			Workbook->ProcessWindowEvent(evt);
+		}
+
+		Threads.clear();
+
+		WorkbookMatches Result;
+		for (auto& task : Tasks)
+		{
+			auto& Matches = task.m_Result.m_Matches;
+			Result.m_Matches.insert(Result.m_Matches.end(), Matches.begin(), Matches.end());
+
+			auto& NewValues = task.m_Result.m_NewValues;
+			Result.m_NewValues.insert(Result.m_NewValues.end(),
+				std::make_move_iterator(NewValues.begin()),
+				std::make_move_iterator(NewValues.end()));
+		}
+
+		return Result;
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <wx/wx.h>
+#include <wx/grid.h>
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	class CWorkbookBase;
+
+	struct FindOptions
+	{
+		wxString m_Pattern;
+		bool m_Regex{ false }; //ECMAScript syntax, otherwise a literal
+		bool m_MatchCase{ true };
+		bool m_WholeCell{ false }; //pattern must match the whole value
+	};
+
+
+	struct FindMatch
+	{
+		size_t m_WSId; //see CWorkbookBase::GetWorksheetById
+		wxGridCellCoords m_Coord;
+	};
+
+
+	class DLLGRID CFindEvent : public wxCommandEvent
+	{
+	public:
+		CFindEvent(
+			wxEventType EventType = wxEVT_NULL,
+			int id = 0,
+			std::vector<FindMatch> Matches = {},
+			size_t Scanned = 0,
+			size_t Total = 0) :
+			wxCommandEvent(EventType, id), m_Matches{ std::move(Matches) }, m_Scanned{ Scanned }, m_Total{ Total } {}
+
+		wxEvent* Clone() const override {
+			return new CFindEvent(*this);
+		}
+
+		//matches found since the previous event (not ordered)
+		const std::vector<FindMatch>& GetMatches() const {
+			return m_Matches;
+		}
+
+		//number of cells scanned so far and in total
+		size_t GetScanned() const {
+			return m_Scanned;
+		}
+
+		size_t GetTotal() const {
+			return m_Total;
+		}
+
+	private:
+		std::vector<FindMatch> m_Matches;
+		size_t m_Scanned, m_Total;
+	};
+
+
+
+	/*
+		Precompiled regex or literal matcher.
+		Matches and Replace can be called from several threads at the same time.
+	*/
+	class DLLGRID CMatcher
+	{
+	public:
+		//throws std::regex_error if the pattern is not a valid regular expression
+		CMatcher(const FindOptions& Options);
+
+		bool Matches(const wxString& Value) const;
+
+		//replaces every match in Value (the whole value if m_WholeCell), $n refers to regex groups
+		wxString Replace(const wxString& Value, const wxString& Replacement) const;
+
+	private:
+		FindOptions m_Options;
+		std::wstring m_Literal; //lower case if not m_MatchCase
+		std::wregex m_Regex;
+	};
+
+
+	//matches of the whole workbook, ordered by page then row then column
+	struct WorkbookMatches
+	{
+		std::vector<FindMatch> m_Matches;
+		std::vector<wxString> m_NewValues; //only if a replacement is given
+	};
+
+	/*
+		Scans the populated cells of every worksheet on worker threads and sends ssEVT_WB_FINDPROGRESS.
+		Values are copied on the calling thread first, workers never call into the grid table.
+		The calling thread only sends the progress events and does not dispatch user input,
+		therefore the worksheets cannot change before the matches are returned (and replaced).
+	*/
+	WorkbookMatches ScanWorkbook(
+		CWorkbookBase* Workbook,
+		const CMatcher& Matcher,
+		const wxString* Replacement = nullptr);
+}
+
+
+//matches found during CWorkbookBase::FindAll or ReplaceAll
+DLLGRID wxDECLARE_EVENT(ssEVT_WB_FINDPROGRESS, grid::CFindEvent);
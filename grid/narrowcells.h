@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <charconv>
+#include <cctype>
+#include <cstdint>
+#include <system_error>
+
+#include <wx/string.h>
+
+
+
+namespace grid
+{
+	//cells as contiguous narrow characters
+	struct NarrowCells
+	{
+		std::string m_Chars;
+		std::vector<size_t> m_Offsets; //i-th cell is [m_Offsets[i], m_Offsets[i+1])
+
+		//Numbers are ASCII, other characters are UTF-8 encoded (bytes >= 0x80) so that parsing fails
+		void Append(const wxString& Value)
+		{
+			m_Offsets.push_back(m_Chars.size());
+
+			for (auto ch : Value)
+			{
+				std::uint32_t Code = ch.GetValue();
+				if (Code < 0x80)
+					m_Chars.push_back((char)Code);
+				else if (Code < 0x800)
+				{
+					m_Chars.push_back((char)(0xC0 | (Code >> 6)));
+					m_Chars.push_back((char)(0x80 | (Code & 0x3F)));
+				}
+				else if (Code < 0x10000)
+				{
+					m_Chars.push_back((char)(0xE0 | (Code >> 12)));
+					m_Chars.push_back((char)(0x80 | ((Code >> 6) & 0x3F)));
+					m_Chars.push_back((char)(0x80 | (Code & 0x3F)));
+				}
+				else
+				{
+					m_Chars.push_back((char)(0xF0 | (Code >> 18)));
+					m_Chars.push_back((char)(0x80 | ((Code >> 12) & 0x3F)));
+					m_Chars.push_back((char)(0x80 | ((Code >> 6) & 0x3F)));
+					m_Chars.push_back((char)(0x80 | (Code & 0x3F)));
+				}
+			}
+		}
+
+		//must be called after the last cell is appended
+		void Close() {
+			m_Offsets.push_back(m_Chars.size());
+		}
+
+		size_t size() const {
+			return m_Offsets.empty() ? 0 : m_Offsets.size() - 1;
+		}
+
+		const char* begin(size_t i) const {
+			return m_Chars.data() + m_Offsets[i];
+		}
+
+		const char* end(size_t i) const {
+			return m_Chars.data() + m_Offsets[i + 1];
+		}
+	};
+
+
+	/*
+		Surrounding whitespace and a leading + are allowed, returns false if [Begin, End) is not a number.
+		inf, infinity and nan (accepted by from_chars in any case) are not numbers.
+	*/
+	template<typename T>
+	bool ParseNumber(const char* Begin, const char* End, T& Value)
+	{
+		while (Begin < End && std::isspace((unsigned char)*Begin))
+			++Begin;
+
+		while (End > Begin && std::isspace((unsigned char)*(End - 1)))
+			--End;
+
+		//from_chars does not accept a leading +
+		if (End - Begin > 1 && *Begin == '+' && *(Begin + 1) != '-')
+			++Begin;
+
+		//numbers start with a digit or a dot after the sign
+		const char* First = Begin < End && *Begin == '-' ? Begin + 1 : Begin;
+		if (First < End && std::isalpha((unsigned char)*First))
+			return false;
+
+		auto [Ptr, ErrCode] = std::from_chars(Begin, End, Value);
+
+		return Begin != End && ErrCode == std::errc() && Ptr == End;
+	}
+
+
+	//shortest representation that parses back to the same value, or Precision significant digits
+	inline wxString FormatNumber(double Value, int Precision = -1)
+	{
+		char Buffer[32];
+		auto [Ptr, ErrCode] = Precision < 0 ?
+			std::to_chars(Buffer, Buffer + sizeof(Buffer), Value) :
+			std::to_chars(Buffer, Buffer + sizeof(Buffer), Value, std::chars_format::general, Precision);
+
+		return wxString(Buffer, Ptr - Buffer);
+	}
+}
@@ -208,11 +208,14 @@ namespace grid
 		if (IsDirty && answer == wxNO)
 			return false;
 
+		size_t WSId = worksheet->GetWSId();
+
 		for (size_t i = 0; i < GetPageCount(); i++)
 		{
 			temp = FindWorksheet(i);
 			if (temp == worksheet)
 			{
+				m_WorkbookBase->ForgetWorksheet(worksheet);
 				DeletePage(i);
 				m_WorkbookBase->MarkDirty();
 
@@ -220,30 +223,9 @@ namespace grid
 			}
 		}
 
-	
-		auto ProcessStack = [&](auto& stk)
-		{
-			std::stack<std::unique_ptr<WSUndoRedoEvent>> temp;
-
-			while (!stk.empty())
-			{
-				auto UndoRedoEvt = std::move(stk.top());
-
-				if (UndoRedoEvt->GetEventSource() != worksheet)
-					temp.push(std::move(UndoRedoEvt));
-
-				stk.pop();
-			}
-
-			while (!temp.empty())
-			{
-				stk.push(std::move(temp.top()));
-				temp.pop();
-			}
-		};
-
-		ProcessStack(m_WorkbookBase->m_UndoStack);
-		ProcessStack(m_WorkbookBase->m_RedoStack);
+		//worksheet is already destroyed, only its id is used
+		m_WorkbookBase->m_UndoStack.erase_worksheet(WSId);
+		m_WorkbookBase->m_RedoStack.erase_worksheet(WSId);
 
 		return true;
 	}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+
+
+namespace grid
+{
+	/*
+		Calls func(First, Last) on consecutive chunks of [0, N) using the hardware threads.
+		The first chunk runs on the calling thread, returns when all chunks are done.
+		Chunk boundaries are multiples of Align and chunks are not smaller than MinChunk (except the last).
+		func must not throw.
+	*/
+	template<typename Func>
+	void ParallelFor(
+		size_t N, 
+		Func&& func, 
+		size_t MinChunk = 4096, 
+		size_t Align = 1)
+	{
+		if (N == 0)
+			return;
+
+		size_t NThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+		NThreads = std::min(NThreads, (N + MinChunk - 1) / std::max<size_t>(MinChunk, 1));
+
+		if (NThreads <= 1)
+		{
+			func(size_t{ 0 }, N);
+			return;
+		}
+
+		size_t Chunk = (N + NThreads - 1) / NThreads;
+		Chunk = (Chunk + Align - 1) / Align * Align;
+
+		std::vector<std::jthread> Threads;
+		for (size_t First = Chunk; First < N; First += Chunk)
+		{
+			size_t Last = std::min(First + Chunk, N);
+			Threads.emplace_back([&func, First, Last] { func(First, Last); });
+		}
+
+		func(size_t{ 0 }, std::min(Chunk, N));
+
+		//jthread joins when destroyed
+	}
+
+
+	/*
+		Stable sort: chunks are sorted on separate threads and then merged pairwise.
+		Adjacent runs are merged left to right, therefore equal elements keep their order.
+	*/
+	template<typename RandomIt, typename Compare>
+	void ParallelStableSort(
+		RandomIt First, 
+		RandomIt Last, 
+		Compare comp, 
+		size_t MinChunk = 16384)
+	{
+		size_t N = Last - First;
+
+		size_t NChunks = std::max<size_t>(1, std::thread::hardware_concurrency());
+		NChunks = std::min(NChunks, (N + MinChunk - 1) / std::max<size_t>(MinChunk, 1));
+
+		if (NChunks <= 1)
+		{
+			std::stable_sort(First, Last, comp);
+			return;
+		}
+
+		size_t Chunk = (N + NChunks - 1) / NChunks;
+
+		ParallelFor(NChunks, [&](size_t Begin, size_t End)
+		{
+			for (size_t k = Begin; k < End; ++k)
+				std::stable_sort(First + k * Chunk, First + std::min((k + 1) * Chunk, N), comp);
+		}, 1);
+
+		for (size_t Width = Chunk; Width < N; Width *= 2)
+		{
+			size_t NMerges = (N + 2 * Width - 1) / (2 * Width);
+
+			ParallelFor(NMerges, [&](size_t Begin, size_t End)
+			{
+				for (size_t k = Begin; k < End; ++k)
+				{
+					size_t Lo = k * 2 * Width;
+					size_t Mid = std::min(Lo + Width, N), Hi = std::min(Lo + 2 * Width, N);
+
+					if (Mid < Hi)
+						std::inplace_merge(First + Lo, First + Mid, First + Hi, comp);
+				}
+			}, 1);
+		}
+	}
+}
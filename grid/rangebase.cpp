@@ -1,14 +1,106 @@
 #include "rangebase.h"
 
+#include <limits>
+#include <string>
+#include <numeric>
+#include <cmath>
+#include <cwchar>
+#include <climits>
+#include <string_view>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+
 #include "worksheetbase.h"
 #include "workbookbase.h"
+#include "ntbkbase.h"
 #include "ws_funcs.h"
+#include "undoredo.h"
+#include "valueindex.h"
+#include "parallel.h"
+#include "narrowcells.h"
+#include "sketches.h"
 
 
 
 
 namespace grid
 {
+	//The grid table is only accessed from the calling thread
+	static NarrowCells ReadNarrow(
+		const CWorksheetBase* ws, 
+		const wxGridCellCoords& TL, 
+		size_t NRows, 
+		size_t NCols, 
+		CRangeBase::ORDER order)
+	{
+		NarrowCells Cells;
+		Cells.m_Offsets.reserve(NRows * NCols + 1);
+		Cells.m_Chars.reserve(NRows * NCols * 8);
+
+		auto Table = ws->GetTable();
+
+		auto Append = [&](size_t i, size_t j)
+		{
+			Cells.Append(Table->GetValue(TL.GetRow() + (int)i, TL.GetCol() + (int)j));
+		};
+
+		if (order == CRangeBase::ORDER::ROWMAJOR)
+		{
+			for (size_t i = 0; i < NRows; ++i)
+				for (size_t j = 0; j < NCols; ++j)
+					Append(i, j);
+		}
+		else
+		{
+			for (size_t j = 0; j < NCols; ++j)
+				for (size_t i = 0; i < NRows; ++i)
+					Append(i, j);
+		}
+
+		Cells.Close();
+
+		return Cells;
+	}
+
+
+	template<typename T>
+	static NumericData<T> ParseNumbers(const NarrowCells& Cells)
+	{
+		size_t N = Cells.size();
+
+		NumericData<T> Data;
+		Data.m_Values.resize(N);
+		Data.m_Errors.assign((N + 63) / 64, 0);
+
+		T Invalid{};
+		if constexpr (std::is_floating_point_v<T>)
+			Invalid = std::numeric_limits<T>::quiet_NaN();
+
+		//chunks are multiples of 64, therefore threads never write the same word of the bitmap
+		ParallelFor(N, [&](size_t First, size_t Last)
+		{
+			for (size_t i = First; i < Last; ++i)
+			{
+				T Value{};
+				if (!ParseNumber(Cells.begin(i), Cells.end(i), Value))
+				{
+					Value = Invalid;
+					Data.m_Errors[i / 64] |= std::uint64_t{ 1 } << (i % 64);
+				}
+
+				Data.m_Values[i] = Value;
+			}
+		}, 8192, 64);
+
+		return Data;
+	}
+
+
 
 
 	CRangeBase::CRangeBase(grid::CWorksheetBase* ws, const wxGridCellCoords& TL, const wxGridCellCoords& BR)
@@ -234,6 +326,25 @@ namespace grid
 
 
 
+	RowsView CRangeBase::rows() const
+	{
+		return RowsView(RowsGen{ m_WSheet, m_TL.GetRow(), m_TL.GetCol(), (int)ncols() }, (std::ptrdiff_t)nrows());
+	}
+
+
+	ColsView CRangeBase::cols() const
+	{
+		return ColsView(ColsGen{ m_WSheet, m_TL.GetRow(), m_TL.GetCol(), (int)nrows() }, (std::ptrdiff_t)ncols());
+	}
+
+
+	CellsView CRangeBase::cells() const
+	{
+		return CellsView(CellsGen{ m_WSheet, m_TL.GetRow(), m_TL.GetCol(), (int)ncols() }, (std::ptrdiff_t)(nrows() * ncols()));
+	}
+
+
+
 	std::list<CRangeBase*> CRangeBase::split() const
 	{
 		std::list<CRangeBase*> retList;
@@ -325,6 +436,837 @@ namespace grid
 	}
 
 
+	void CRangeBase::read(
+		std::span<wxString> Buffer, 
+		ORDER order) const
+	{
+		size_t NRows = nrows(), NCols = ncols();
+
+		if (Buffer.size() != NRows * NCols)
+			throw std::exception("Buffer size does not match the size of the range.");
+
+		auto Table = m_WSheet->GetTable();
+		int Row0 = topleft().GetRow(), Col0 = topleft().GetCol();
+
+		for (size_t i = 0; i < NRows; ++i)
+		{
+			for (size_t j = 0; j < NCols; ++j)
+			{
+				size_t Index = order == ORDER::ROWMAJOR ? i * NCols + j : j * NRows + i;
+
+				wxString& Value = Buffer[Index];
+				Value = Table->GetValue(Row0 + (int)i, Col0 + (int)j);
+
+				//trimming allocates, only trim if necessary
+				if (!Value.empty() && (wxIsspace(Value[0]) || wxIsspace(Value.Last())))
+					Value.Trim().Trim(false);
+			}
+		}
+	}
+
+
+	void CRangeBase::write(
+		std::span<const wxString> Buffer, 
+		ORDER order)
+	{
+		size_t NRows = nrows(), NCols = ncols();
+
+		if (Buffer.size() != NRows * NCols)
+			throw std::exception("Buffer size does not match the size of the range.");
+
+		int Row0 = topleft().GetRow(), Col0 = topleft().GetCol();
+
+		m_WSheet->BeginBatch();
+
+		for (size_t i = 0; i < NRows; ++i)
+		{
+			for (size_t j = 0; j < NCols; ++j)
+			{
+				size_t Index = order == ORDER::ROWMAJOR ? i * NCols + j : j * NRows + i;
+				m_WSheet->SetValue(Row0 + (int)i, Col0 + (int)j, Buffer[Index], false);
+			}
+		}
+
+		m_WSheet->EndBatch();
+
+		m_WSheet->MarkDirty();
+	}
+
+
+	NumericData<double> CRangeBase::to_doubles(ORDER order) const
+	{
+		return ParseNumbers<double>(ReadNarrow(m_WSheet, m_TL, nrows(), ncols(), order));
+	}
+
+
+	NumericData<std::int64_t> CRangeBase::to_int64(ORDER order) const
+	{
+		return ParseNumbers<std::int64_t>(ReadNarrow(m_WSheet, m_TL, nrows(), ncols(), order));
+	}
+
+
+	Stats CRangeBase::stats() const
+	{
+		return ComputeStats(to_doubles().m_Values);
+	}
+
+
+	std::vector<Stats> CRangeBase::colstats() const
+	{
+		auto Data = to_doubles(ORDER::COLMAJOR);
+		std::span<const double> Values(Data.m_Values);
+
+		size_t NRows = nrows();
+
+		std::vector<Stats> Result;
+		Result.reserve(ncols());
+		for (int j = 0; j < ncols(); ++j)
+			Result.push_back(ComputeStats(Values.subspan(j * NRows, NRows)));
+
+		return Result;
+	}
+
+
+	std::vector<ColumnProfile> CRangeBase::describe(const std::vector<double>& Probs) const
+	{
+		for (double p : Probs)
+		{
+			if (!(p >= 0.0 && p <= 1.0))
+				throw std::exception("Quantile probabilities must be in [0, 1].");
+		}
+
+		auto Cols = split();
+		std::vector<std::unique_ptr<CRangeBase>> Owned(Cols.begin(), Cols.end());
+
+		size_t NRows = nrows(), NCols = Owned.size();
+
+		//cells are read on this thread, the pass runs on workers
+		std::vector<NarrowCells> Columns;
+		for (const auto& Col : Owned)
+			Columns.push_back(ReadNarrow(m_WSheet, Col->topleft(), NRows, 1, ORDER::ROWMAJOR));
+
+		struct Partial
+		{
+			CELLTYPE m_Type{ CELLTYPE::EMPTY };
+			size_t m_Empty{ 0 };
+			CHyperLogLog m_Distinct;
+			CTDigest m_Digest;
+			Stats m_Numeric;
+		};
+
+		//a task is a chunk of rows of a column, therefore a few tall columns still use all threads
+		constexpr size_t TASKROWS = 65536;
+		size_t NChunks = std::max<size_t>(1, (NRows + TASKROWS - 1) / TASKROWS);
+
+		std::vector<Partial> Partials(NCols * NChunks);
+
+		ParallelFor(Partials.size(), [&](size_t First, size_t Last)
+		{
+			std::vector<double> Numbers;
+
+			for (size_t t = First; t < Last; ++t)
+			{
+				const auto& Cells = Columns[t / NChunks];
+				size_t Begin = t % NChunks * TASKROWS, End = std::min(Begin + TASKROWS, NRows);
+
+				auto& P = Partials[t];
+
+				Numbers.clear();
+				for (size_t i = Begin; i < End; ++i)
+				{
+					const char* b = Cells.begin(i), *e = Cells.end(i);
+
+					auto Type = ClassifyCell(b, e);
+					if (Type == CELLTYPE::EMPTY)
+					{
+						P.m_Empty++;
+						continue;
+					}
+
+					P.m_Type = WidenType(P.m_Type, Type);
+
+					//distinct values are counted on trimmed values
+					while (b < e && std::isspace((unsigned char)*b))
+						++b;
+
+					while (e > b && std::isspace((unsigned char)*(e - 1)))
+						--e;
+
+					P.m_Distinct.Add(HashBytes(b, e));
+
+					double Value{};
+					if ((Type == CELLTYPE::INTEGER || Type == CELLTYPE::FLOAT) && ParseNumber(b, e, Value))
+					{
+						Numbers.push_back(Value);
+						P.m_Digest.Add(Value);
+					}
+				}
+
+				P.m_Numeric = ComputeStats(Numbers);
+			}
+		}, 1);
+
+		std::vector<ColumnProfile> Result(NCols);
+		for (size_t j = 0; j < NCols; ++j)
+		{
+			auto& Col = Partials[j * NChunks];
+			for (size_t k = 1; k < NChunks; ++k)
+			{
+				auto& P = Partials[j * NChunks + k];
+
+				Col.m_Type = WidenType(Col.m_Type, P.m_Type);
+				Col.m_Empty += P.m_Empty;
+				Col.m_Distinct.Merge(P.m_Distinct);
+				Col.m_Digest.Merge(P.m_Digest);
+				Col.m_Numeric.Merge(P.m_Numeric);
+			}
+
+			auto& Profile = Result[j];
+			Profile.m_Type = Col.m_Type;
+			Profile.m_Empty = Col.m_Empty;
+			Profile.m_Numeric = Col.m_Numeric;
+			Profile.m_StdDev = std::sqrt(Col.m_Numeric.m_Var);
+
+			//the estimate can slightly exceed the number of values
+			size_t NValues = NRows - Col.m_Empty;
+			Profile.m_Distinct = std::min(NValues, (size_t)std::llround(Col.m_Distinct.Estimate()));
+
+			for (double p : Probs)
+				Profile.m_Quantiles.push_back(Col.m_Digest.Quantile(p));
+		}
+
+		return Result;
+	}
+
+
+	/*
+		Key whose code unit order is the collation order of the C runtime's locale (as wxStricoll),
+		so that rows are ordered by comparing keys rather than collating on every comparison
+	*/
+	static std::wstring CollationKey(const wxString& Text)
+	{
+		std::wstring Str = Text.ToStdWstring();
+		if (Str.empty())
+			return Str;
+
+		size_t N = std::wcsxfrm(nullptr, Str.c_str(), 0);
+		if (N == size_t(-1) || N >= INT_MAX)
+			return Str;
+
+		std::wstring Key(N, L'\0');
+		std::wcsxfrm(Key.data(), Str.c_str(), N + 1);
+
+		return Key;
+	}
+
+
+	void CRangeBase::sort(const std::vector<SortKey>& Keys)
+	{
+		if (Keys.empty())
+			return;
+
+		int NRows = nrows(), NCols = ncols();
+
+		for (const auto& Key : Keys)
+		{
+			if (Key.m_Col < 0 || Key.m_Col >= NCols)
+				throw std::exception("Sort column is outside of the range.");
+		}
+
+		//keys are extracted once, comparisons do not touch the grid
+		struct ColumnKey
+		{
+			SortKey m_Key;
+			std::vector<double> m_Numbers; //NaN if not a number
+			std::vector<std::wstring> m_Texts; //collation keys of the lower case text
+		};
+
+		auto Table = m_WSheet->GetTable();
+
+		std::vector<ColumnKey> ColKeys(Keys.size());
+		for (size_t n = 0; n < Keys.size(); ++n)
+		{
+			auto& ColKey = ColKeys[n];
+			ColKey.m_Key = Keys[n];
+
+			int Col = m_TL.GetCol() + Keys[n].m_Col;
+
+			if (Keys[n].m_Numeric)
+			{
+				auto Cells = ReadNarrow(m_WSheet, { m_TL.GetRow(), Col }, NRows, 1, ORDER::ROWMAJOR);
+				ColKey.m_Numbers = ParseNumbers<double>(Cells).m_Values;
+			}
+			else
+			{
+				std::vector<wxString> Texts(NRows);
+				for (int i = 0; i < NRows; ++i)
+					Texts[i] = Table->GetValue(m_TL.GetRow() + i, Col);
+
+				ColKey.m_Texts.resize(NRows);
+				ParallelFor(NRows, [&](size_t First, size_t Last)
+				{
+					for (size_t i = First; i < Last; ++i)
+						ColKey.m_Texts[i] = CollationKey(Texts[i].MakeLower());
+				});
+			}
+		}
+
+		auto Less = [&ColKeys](int a, int b)
+		{
+			for (const auto& ColKey : ColKeys)
+			{
+				int Cmp = 0;
+
+				if (ColKey.m_Key.m_Numeric)
+				{
+					double x = ColKey.m_Numbers[a], y = ColKey.m_Numbers[b];
+					bool xNaN = std::isnan(x), yNaN = std::isnan(y);
+
+					//missing values are last regardless of the direction
+					if (xNaN || yNaN)
+					{
+						if (xNaN != yNaN)
+							return yNaN;
+						continue;
+					}
+
+					Cmp = (x > y) - (x < y);
+				}
+				else
+				{
+					const std::wstring& x = ColKey.m_Texts[a];
+					const std::wstring& y = ColKey.m_Texts[b];
+
+					if (x.empty() || y.empty())
+					{
+						if (x.empty() != y.empty())
+							return y.empty();
+						continue;
+					}
+
+					Cmp = x.compare(y);
+				}
+
+				if (Cmp != 0)
+					return ColKey.m_Key.m_Ascending ? Cmp < 0 : Cmp > 0;
+			}
+
+			return false;
+		};
+
+		std::vector<int> Perm(NRows);
+		std::iota(Perm.begin(), Perm.end(), 0);
+
+		ParallelStableSort(Perm.begin(), Perm.end(), Less);
+
+		//already sorted
+		if (std::is_sorted(Perm.begin(), Perm.end()))
+			return;
+
+		m_WSheet->PermuteRows(m_TL, m_BR, Perm);
+
+		if (auto Workbook = m_WSheet->GetWorkbook())
+		{
+			auto evt = std::make_unique<RowsSortedEvent>(m_WSheet, m_TL, m_BR, std::move(Perm));
+			Workbook->PushUndoEvent(std::move(evt));
+		}
+	}
+
+
+	//trimmed values of a column, read on the calling thread
+	static std::vector<wxString> ReadColumn(
+		CWorksheetBase* ws, 
+		int Row0, 
+		int Col, 
+		int NRows)
+	{
+		std::vector<wxString> Values(NRows);
+
+		auto Table = ws->GetTable();
+		for (int i = 0; i < NRows; ++i)
+		{
+			wxString& Value = Values[i];
+			Value = Table->GetValue(Row0 + i, Col);
+
+			if (!Value.empty() && (wxIsspace(Value[0]) || wxIsspace(Value.Last())))
+				Value.Trim().Trim(false);
+		}
+
+		return Values;
+	}
+
+
+	//trimmed key columns of a range, compared and hashed row-wise
+	struct RowKeys
+	{
+		std::vector<std::vector<wxString>> m_Cols;
+
+		RowKeys(CWorksheetBase* ws, const wxGridCellCoords& TL, int NRows, const std::vector<int>& Cols)
+		{
+			for (int Col : Cols)
+				m_Cols.push_back(ReadColumn(ws, TL.GetRow(), TL.GetCol() + Col, NRows));
+		}
+
+		std::wstring_view Key(size_t Row, size_t k) const
+		{
+			const wxString& Value = m_Cols[k][Row];
+			return std::wstring_view(Value.wc_str(), Value.length());
+		}
+
+		bool Same(size_t a, size_t b) const
+		{
+			for (size_t k = 0; k < m_Cols.size(); ++k)
+				if (Key(a, k) != Key(b, k))
+					return false;
+
+			return true;
+		}
+
+		//computed in parallel
+		std::vector<std::uint64_t> Hash(size_t NRows) const
+		{
+			std::vector<std::uint64_t> Hashes(NRows);
+
+			ParallelFor(NRows, [&](size_t First, size_t Last)
+			{
+				std::hash<std::wstring_view> Hasher;
+				for (size_t i = First; i < Last; ++i)
+				{
+					std::uint64_t h = 0;
+					for (size_t k = 0; k < m_Cols.size(); ++k)
+						h = (h ^ Hasher(Key(i, k))) * 0x9E3779B97F4A7C15ULL + k;
+
+					Hashes[i] = h;
+				}
+			});
+
+			return Hashes;
+		}
+	};
+
+
+	size_t CRangeBase::dedupe(const std::vector<int>& KeyCols)
+	{
+		int NRows = nrows(), NCols = ncols();
+
+		std::vector<int> Cols = KeyCols;
+		if (Cols.empty())
+		{
+			Cols.resize(NCols);
+			std::iota(Cols.begin(), Cols.end(), 0);
+		}
+
+		for (int Col : Cols)
+		{
+			if (Col < 0 || Col >= NCols)
+				throw std::exception("Key column is outside of the range.");
+		}
+
+		//keys are read on the calling thread
+		RowKeys Keys(m_WSheet, m_TL, NRows, Cols);
+		auto Hashes = Keys.Hash(NRows);
+
+		/*
+			Rows are split into shards by hash, each thread visits all rows in order but only handles its shard.
+			Therefore the first occurrence is kept without any synchronization.
+		*/
+		size_t NShards = std::max<size_t>(1, std::thread::hardware_concurrency());
+		std::vector<char> IsDuplicate(NRows, 0);
+
+		ParallelFor(NShards, [&](size_t FirstShard, size_t LastShard)
+		{
+			for (size_t Shard = FirstShard; Shard < LastShard; ++Shard)
+			{
+				std::unordered_map<std::uint64_t, int> Seen;
+				std::unordered_multimap<std::uint64_t, int> Collisions; //different keys with the same hash
+
+				for (int i = 0; i < NRows; ++i)
+				{
+					std::uint64_t h = Hashes[i];
+					if (h % NShards != Shard)
+						continue;
+
+					auto [it, Inserted] = Seen.try_emplace(h, i);
+					if (Inserted)
+						continue;
+
+					if (Keys.Same(it->second, i))
+					{
+						IsDuplicate[i] = 1;
+						continue;
+					}
+
+					auto [First, Last] = Collisions.equal_range(h);
+					bool Found = std::any_of(First, Last, [&](const auto& Elem) { return Keys.Same(Elem.second, i); });
+
+					if (Found)
+						IsDuplicate[i] = 1;
+					else
+						Collisions.emplace(h, i);
+				}
+			}
+		}, 1);
+
+		//kept rows first, removed rows move to the bottom of the range
+		std::vector<int> Perm, Removed;
+		Perm.reserve(NRows);
+		for (int i = 0; i < NRows; ++i)
+		{
+			if (IsDuplicate[i])
+				Removed.push_back(i);
+			else
+				Perm.push_back(i);
+		}
+
+		if (Removed.empty())
+			return 0;
+
+		Perm.insert(Perm.end(), Removed.begin(), Removed.end());
+
+		m_WSheet->PermuteRows(m_TL, m_BR, Perm);
+
+		wxGridCellCoords BottomTL(m_BR.GetRow() - (int)Removed.size() + 1, m_TL.GetCol());
+		auto RemovedCells = m_WSheet->GetPopulatedCells(BottomTL, m_BR);
+		m_WSheet->ClearPopulatedCells(BottomTL, m_BR);
+
+		size_t NRemoved = Removed.size();
+
+		if (auto Workbook = m_WSheet->GetWorkbook())
+		{
+			auto evt = std::make_unique<DuplicatesRemovedEvent>(m_WSheet, m_TL, m_BR, std::move(Removed));
+			evt->SetRemovedCells(std::move(RemovedCells));
+			Workbook->PushUndoEvent(std::move(evt));
+		}
+
+		return NRemoved;
+	}
+
+
+	size_t CRangeBase::join(
+		int KeyCol,
+		const CRangeBase& Lookup,
+		std::vector<int> LookupCols,
+		int DestCol)
+	{
+		if (KeyCol < 0 || KeyCol >= ncols())
+			throw std::exception("Key column is outside of the range.");
+
+		int NLookupCols = Lookup.ncols();
+		if (LookupCols.empty())
+		{
+			for (int j = 1; j < NLookupCols; ++j)
+				LookupCols.push_back(j);
+		}
+
+		if (LookupCols.empty())
+			throw std::exception("Lookup range has no columns to return.");
+
+		for (int Col : LookupCols)
+		{
+			if (Col < 0 || Col >= NLookupCols)
+				throw std::exception("Lookup column is outside of the lookup range.");
+		}
+
+		if (DestCol < 0)
+			DestCol = ncols();
+
+		int NRows = nrows();
+		size_t NOut = LookupCols.size();
+
+		wxGridCellCoords DestTL(m_TL.GetRow(), m_TL.GetCol() + DestCol);
+		wxGridCellCoords DestBR(m_BR.GetRow(), DestTL.GetCol() + (int)NOut - 1);
+
+		if (DestBR.GetCol() >= m_WSheet->GetNumberCols())
+			throw std::exception("Result columns do not fit in the worksheet.");
+
+		int LookupRow0 = Lookup.m_TL.GetRow(), LookupCol0 = Lookup.m_TL.GetCol();
+
+		//hash table over the lookup keys, the first occurrence wins
+		auto LookupKeys = ReadColumn(Lookup.m_WSheet, LookupRow0, LookupCol0, Lookup.nrows());
+
+		std::unordered_map<std::wstring_view, int> KeyToRow;
+		KeyToRow.reserve(LookupKeys.size());
+		for (size_t i = 0; i < LookupKeys.size(); ++i)
+		{
+			if (!LookupKeys[i].empty())
+				KeyToRow.try_emplace(std::wstring_view(LookupKeys[i].wc_str(), LookupKeys[i].length()), (int)i);
+		}
+
+		//lookup values are read before anything is written (both ranges can be on the same worksheet)
+		std::vector<std::vector<wxString>> LookupValues;
+		for (int Col : LookupCols)
+			LookupValues.push_back(ReadColumn(Lookup.m_WSheet, LookupRow0, LookupCol0 + Col, Lookup.nrows()));
+
+		auto Keys = ReadColumn(m_WSheet, m_TL.GetRow(), m_TL.GetCol() + KeyCol, NRows);
+
+		std::vector<wxString> Buffer((size_t)NRows * NOut);
+		std::atomic<size_t> NMatched{ 0 };
+
+		ParallelFor(NRows, [&](size_t First, size_t Last)
+		{
+			size_t N = 0;
+			for (size_t i = First; i < Last; ++i)
+			{
+				const wxString& Key = Keys[i];
+				auto it = KeyToRow.find(std::wstring_view(Key.wc_str(), Key.length()));
+				if (it == KeyToRow.end()) //empty keys are not in the table
+					continue;
+
+				for (size_t k = 0; k < NOut; ++k)
+					Buffer[i * NOut + k] = LookupValues[k][it->second];
+
+				N++;
+			}
+
+			NMatched += N;
+		});
+
+		auto Before = m_WSheet->GetPopulatedCells(DestTL, DestBR);
+
+		CRangeBase Dest(m_WSheet, DestTL, DestBR);
+		Dest.write(Buffer);
+
+		if (auto Workbook = m_WSheet->GetWorkbook())
+		{
+			auto evt = std::make_unique<DataPasted>(m_WSheet);
+			evt->SetCoords(DestTL, DestBR);
+			evt->SetPaste((int)CWorksheetBase::PASTE::VALUES);
+			evt->SetLabel(L"join");
+			evt->SetInitialCells(std::move(Before));
+			evt->SetFinalCells(m_WSheet->GetPopulatedCells(DestTL, DestBR));
+
+			Workbook->PushUndoEvent(std::move(evt));
+		}
+
+		return NMatched;
+	}
+
+
+	size_t CRangeBase::join(
+		int KeyCol,
+		const wxString& Lookup,
+		std::vector<int> LookupCols,
+		int DestCol)
+	{
+		auto Workbook = m_WSheet->GetWorkbook();
+		if (!Workbook)
+			throw std::exception("Worksheet is not owned by a workbook.");
+
+		return join(KeyCol, CRangeBase(Lookup, Workbook), std::move(LookupCols), DestCol);
+	}
+
+
+	CWorksheetBase* CRangeBase::groupby(
+		const std::vector<int>& KeyCols,
+		const std::vector<Aggregate>& Aggregates,
+		const std::wstring& SheetName) const
+	{
+		auto Workbook = m_WSheet->GetWorkbook();
+		if (!Workbook)
+			throw std::exception("Worksheet is not owned by a workbook.");
+
+		if (KeyCols.empty())
+			throw std::exception("At least one key column is required.");
+
+		int NRows = nrows(), NCols = ncols();
+
+		for (int Col : KeyCols)
+		{
+			if (Col < 0 || Col >= NCols)
+				throw std::exception("Key column is outside of the range.");
+		}
+
+		for (const auto& Agg : Aggregates)
+		{
+			if (Agg.m_Col < 0 || Agg.m_Col >= NCols)
+				throw std::exception("Aggregate column is outside of the range.");
+		}
+
+		size_t NKeys = KeyCols.size(), NAgg = Aggregates.size();
+
+		RowKeys Keys(m_WSheet, m_TL, NRows, KeyCols);
+		auto Hashes = Keys.Hash(NRows);
+
+		//groups in order of first appearance, groups with the same hash are chained
+		struct Groups
+		{
+			std::unordered_map<std::uint64_t, int> m_Heads;
+			std::vector<int> m_Rows, m_Next; //first row of the group
+
+			int FindOrAdd(std::uint64_t Hash, int Row, const RowKeys& Keys)
+			{
+				int NewGroup = (int)m_Rows.size();
+
+				auto [it, Inserted] = m_Heads.try_emplace(Hash, NewGroup);
+				if (!Inserted)
+				{
+					int g = it->second;
+					for (;; g = m_Next[g])
+					{
+						if (Keys.Same(m_Rows[g], Row))
+							return g;
+
+						if (m_Next[g] < 0)
+							break;
+					}
+
+					m_Next[g] = NewGroup;
+				}
+
+				m_Rows.push_back(Row);
+				m_Next.push_back(-1);
+
+				return NewGroup;
+			}
+		};
+
+		//group of each row, first local to the thread's chunk
+		std::vector<int> RowGroups(NRows);
+
+		//partial grouping on each thread, keyed by the first row of the chunk
+		std::mutex Mutex;
+		std::map<size_t, Groups> Partials;
+
+		ParallelFor(NRows, [&](size_t First, size_t Last)
+		{
+			Groups Partial;
+			for (size_t i = First; i < Last; ++i)
+				RowGroups[i] = Partial.FindOrAdd(Hashes[i], (int)i, Keys);
+
+			std::lock_guard lock(Mutex);
+			Partials[First] = std::move(Partial);
+		}, 65536);
+
+		//merged in row order, therefore the order of first appearance is kept
+		Groups Result;
+		for (auto it = Partials.begin(); it != Partials.end(); ++it)
+		{
+			const auto& Partial = it->second;
+
+			std::vector<int> Global(Partial.m_Rows.size());
+			for (size_t g = 0; g < Partial.m_Rows.size(); ++g)
+			{
+				int Row = Partial.m_Rows[g];
+				Global[g] = Result.FindOrAdd(Hashes[Row], Row, Keys);
+			}
+
+			size_t Last = std::next(it) == Partials.end() ? NRows : std::next(it)->first;
+			for (size_t i = it->first; i < Last; ++i)
+				RowGroups[i] = Global[RowGroups[i]];
+		}
+
+		size_t NGroups = Result.m_Rows.size();
+
+		//rows of group g are GroupRows[Offsets[g], Offsets[g + 1]), in row order
+		std::vector<size_t> Offsets(NGroups + 1, 0);
+		for (int g : RowGroups)
+			Offsets[g + 1]++;
+
+		std::partial_sum(Offsets.begin(), Offsets.end(), Offsets.begin());
+
+		std::vector<int> GroupRows(NRows);
+		{
+			std::vector<size_t> Next(Offsets.begin(), Offsets.end() - 1);
+			for (int i = 0; i < NRows; ++i)
+				GroupRows[Next[RowGroups[i]]++] = i;
+		}
+
+		//each column is parsed and summarized once even if it has several aggregates
+		std::vector<int> StatCols;
+		std::vector<size_t> AggStat(NAgg);
+		for (size_t a = 0; a < NAgg; ++a)
+		{
+			auto it = std::find(StatCols.begin(), StatCols.end(), Aggregates[a].m_Col);
+			AggStat[a] = it - StatCols.begin();
+
+			if (it == StatCols.end())
+				StatCols.push_back(Aggregates[a].m_Col);
+		}
+
+		size_t NStats = StatCols.size();
+
+		//same summation as stats(), therefore SUM and MEAN agree with it
+		std::vector<Stats> GroupStats(NGroups * NStats);
+		for (size_t c = 0; c < NStats; ++c)
+		{
+			auto Cells = ReadNarrow(m_WSheet, { m_TL.GetRow(), m_TL.GetCol() + StatCols[c] }, NRows, 1, ORDER::ROWMAJOR);
+			auto Numbers = ParseNumbers<double>(Cells).m_Values;
+
+			ParallelFor(NGroups, [&](size_t First, size_t Last)
+			{
+				std::vector<double> Values;
+				for (size_t g = First; g < Last; ++g)
+				{
+					Values.clear();
+					for (size_t k = Offsets[g]; k < Offsets[g + 1]; ++k)
+						Values.push_back(Numbers[GroupRows[k]]);
+
+					GroupStats[g * NStats + c] = ComputeStats(Values);
+				}
+			}, 1024);
+		}
+
+		size_t NOut = NKeys + NAgg;
+
+		std::vector<wxString> Buffer((NGroups + 1) * NOut);
+
+		const wchar_t* FuncNames[] = { L"SUM", L"COUNT", L"MEAN", L"MIN", L"MAX" };
+
+		for (size_t k = 0; k < NKeys; ++k)
+			Buffer[k] = ColNumtoLetters((size_t)m_TL.GetCol() + KeyCols[k] + 1);
+
+		for (size_t a = 0; a < NAgg; ++a)
+		{
+			wxString Col = ColNumtoLetters((size_t)m_TL.GetCol() + Aggregates[a].m_Col + 1);
+			Buffer[NKeys + a] = wxString(FuncNames[(int)Aggregates[a].m_Func]) + "(" + Col + ")";
+		}
+
+		ParallelFor(NGroups, [&](size_t First, size_t Last)
+		{
+			for (size_t g = First; g < Last; ++g)
+			{
+				wxString* Out = Buffer.data() + (g + 1) * NOut;
+
+				for (size_t k = 0; k < NKeys; ++k)
+					Out[k] = Keys.m_Cols[k][Result.m_Rows[g]];
+
+				for (size_t a = 0; a < NAgg; ++a)
+				{
+					const auto& St = GroupStats[g * NStats + AggStat[a]];
+					auto Func = Aggregates[a].m_Func;
+
+					//no numeric values in the group
+					if (St.m_Count == 0 && Func != AGGREGATE::COUNT && Func != AGGREGATE::SUM)
+						continue;
+
+					double Value = 0;
+					switch (Func)
+					{
+					case AGGREGATE::SUM: Value = St.m_Sum; break;
+					case AGGREGATE::COUNT: Value = (double)St.m_Count; break;
+					case AGGREGATE::MEAN: Value = St.m_Mean; break;
+					case AGGREGATE::MIN: Value = St.m_Min; break;
+					case AGGREGATE::MAX: Value = St.m_Max; break;
+					}
+
+					Out[NKeys + a] = FormatNumber(Value);
+				}
+			}
+		}, 4096);
+
+		int NewRows = std::max((int)NGroups + 1, 1000), NewCols = std::max((int)NOut, 50);
+		if (!Workbook->GetWorksheetNotebook()->ImportAsNewWorksheet(SheetName, NewRows, NewCols))
+			return nullptr;
+
+		auto ws = Workbook->GetActiveWS();
+
+		CRangeBase Dest(ws, { 0, 0 }, { (int)NGroups, (int)NOut - 1 });
+		Dest.write(Buffer);
+
+		return ws;
+	}
+
+
 	wxString CRangeBase::get(int pos) const
 	{
 		assert(pos >= 0);
@@ -340,20 +1282,69 @@ namespace grid
 
 
 
+	std::vector<wxGridCellCoords> CRangeBase::find(
+		const wxString& Value,
+		bool Prefix) const
+	{
+		if (auto Index = m_WSheet->GetValueIndex())
+			return Index->Find(Value, Prefix, m_TL, m_BR);
+
+		std::vector<wxGridCellCoords> Result;
+
+		wxString Key = wxString(Value).Trim().Trim(false);
+		if (Key.empty())
+			return Result;
+
+		const auto& Content = m_WSheet->GetChangedCells_Content();
+		auto Table = m_WSheet->GetTable();
+
+		for (auto it = Content.lower_bound(m_TL); it != Content.end() && it->GetRow() <= m_BR.GetRow(); ++it)
+		{
+			if (it->GetCol() < m_TL.GetCol() || it->GetCol() > m_BR.GetCol())
+				continue;
+
+			wxString CellValue = Table->GetValue(it->GetRow(), it->GetCol()).Trim().Trim(false);
+
+			if (Prefix ? CellValue.StartsWith(Key) : CellValue == Key)
+				Result.push_back(*it);
+		}
+
+		return Result;
+	}
+
+
 	void CRangeBase::replace(
 		const wxString& Value,
 		const wxString& newValue)
 	{
-		int NRows = nrows();
-		int NCols = ncols();
+		//empty cells are not indexed
+		if (Value.empty())
+		{
+			for (int i = 0; i < nrows(); ++i)
+				for (int j = 0; j < ncols(); ++j)
+				{
+					if (get(i, j).empty())
+						set(i, j, newValue);
+				}
+
+			return;
+		}
 
-		int k = 0;
-		for (int i = 0; i < NRows; ++i)
-			for (int j = 0; j < NCols; ++j)
-			{
-				if (get(i, j) == Value)
-					set(i, j, newValue);
-			}
+		//setting a cell updates the index, therefore the matches are collected first
+		auto Matches = find(Value);
+
+		//an untrimmed Value never matches a trimmed cell
+		if (Matches.empty() || Value != wxString(Value).Trim().Trim(false))
+			return;
+
+		m_WSheet->BeginBatch();
+
+		for (const auto& Coord : Matches)
+			m_WSheet->SetCellValue(Coord.GetRow(), Coord.GetCol(), newValue, false);
+
+		m_WSheet->EndBatch();
+
+		m_WSheet->MarkDirty();
 	}
 
 
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <span>
+#include <vector>
+#include <bit>
+#include <cstdint>
 #include <wx/wx.h>
 #include <wx/grid.h>
 
+#include "rangeviews.h"
+#include "aggregates.h"
+#include "celltype.h"
 #include "dllimpexp.h"
 
 
@@ -12,11 +19,71 @@ namespace grid
 	class CWorksheetBase;
 	class CWorkbookBase;
 
+
+	/*
+		Numbers parsed from a range.
+		Bit i of m_Errors is set if the i-th cell is empty or not a number (value is then NaN or 0)
+	*/
+	template<typename T>
+	struct NumericData
+	{
+		std::vector<T> m_Values;
+		std::vector<std::uint64_t> m_Errors;
+
+		bool IsError(size_t i) const {
+			return (m_Errors[i / 64] >> (i % 64)) & 1;
+		}
+
+		size_t NumErrors() const 
+		{
+			size_t N = 0;
+			for (auto Word : m_Errors)
+				N += std::popcount(Word);
+
+			return N;
+		}
+	};
+
+
+	//a column of the range used as a key by CRangeBase::sort
+	struct SortKey
+	{
+		int m_Col{ 0 }; //relative to the first column of the range
+		bool m_Ascending{ true };
+		bool m_Numeric{ false }; //otherwise compared as case-insensitive text in the locale's collation order
+	};
+
+
+	//summary of a column reported by CRangeBase::describe
+	struct ColumnProfile
+	{
+		CELLTYPE m_Type{ CELLTYPE::EMPTY }; //widest type of the cells
+		size_t m_Empty{ 0 }; //empty or whitespace only cells
+		size_t m_Distinct{ 0 }; //estimated number of distinct non-empty values
+		Stats m_Numeric; //numeric cells
+		double m_StdDev{ std::numeric_limits<double>::quiet_NaN() };
+		std::vector<double> m_Quantiles; //approximate, of the numeric cells
+	};
+
+
+	enum class AGGREGATE { SUM = 0, COUNT, MEAN, MIN, MAX };
+
+	//aggregate of the numeric cells of a column of the range used by CRangeBase::groupby
+	struct Aggregate
+	{
+		int m_Col{ 0 }; //relative to the first column of the range
+		AGGREGATE m_Func{ AGGREGATE::SUM };
+	};
+
+
 	class DLLGRID CRangeBase
 	{
 	public:
 		enum class SELECT { ALLROWS = -1, ALLCOLS = -2 };
 
+		//layout of the buffers used by read and write
+		enum class ORDER { ROWMAJOR = 0, COLMAJOR };
+
 	public:
 		CRangeBase() = default;
 		
@@ -38,6 +105,17 @@ namespace grid
 		virtual ~CRangeBase();
 
 
+		/*
+			Views over the range, nothing is allocated and no range strings are built.
+			for (auto Col : rng.cols())
+				for (const auto& cell : Col)
+					cell.value();
+		*/
+		RowsView rows() const;
+		ColsView cols() const;
+		CellsView cells() const; //row-major
+
+
 		/*
 			Split the range (made up of N cols) into individual column ranges
 			If range contains only a single col, returns the range itself
@@ -57,6 +135,14 @@ namespace grid
 			int NCols = (int)SELECT::ALLCOLS) const;
 
 
+		/*
+			Worksheet coordinates of the cells whose trimmed value equals Value (or starts with it if Prefix).
+			Uses the worksheet's value index if enabled, otherwise scans the populated cells.
+		*/
+		std::vector<wxGridCellCoords> find(
+			const wxString& Value,
+			bool Prefix = false) const;
+
 		//replace all occurences of Value with new Value
 		void replace(
 			const wxString& Value,
@@ -99,6 +185,87 @@ namespace grid
 		void clear() const;
 
 
+		/*
+			Copies all values (trimmed, same as get) of the range into Buffer.
+			Buffer must have exactly nrows()*ncols() elements.
+		*/
+		void read(
+			std::span<wxString> Buffer, 
+			ORDER order = ORDER::ROWMAJOR) const;
+
+		/*
+			Writes Buffer to the range, Buffer must have exactly nrows()*ncols() elements.
+			Grid is repainted and worksheet is marked dirty only once.
+		*/
+		void write(
+			std::span<const wxString> Buffer, 
+			ORDER order = ORDER::ROWMAJOR);
+
+
+		/*
+			Parses all cells of the range as numbers using multiple threads.
+			ORDER::COLMAJOR gives the columns one after another (column-wise extraction).
+		*/
+		NumericData<double> to_doubles(ORDER order = ORDER::ROWMAJOR) const;
+		NumericData<std::int64_t> to_int64(ORDER order = ORDER::ROWMAJOR) const;
+
+		//count, sum, mean, min, max and variance of the numeric cells
+		Stats stats() const;
+
+		//one Stats per column
+		std::vector<Stats> colstats() const;
+
+		/*
+			Profile of each column in a single parallel pass over the columns (see split).
+			Quantiles are computed at the probabilities in Probs, each must be in [0, 1].
+		*/
+		std::vector<ColumnProfile> describe(const std::vector<double>& Probs = { 0.25, 0.5, 0.75 }) const;
+
+
+		/*
+			Sorts the rows of the range by Keys (first key has the highest priority), equal rows keep their order.
+			Empty cells, and cells that are not numbers for a numeric key, are placed last.
+			Values and formats are moved, undo only keeps the permutation.
+		*/
+		void sort(const std::vector<SortKey>& Keys);
+
+		/*
+			Removes the rows whose key columns (relative to the range, all columns if empty) repeat an earlier row.
+			Remaining rows move up keeping their order, rows at the bottom of the range are cleared.
+			Returns the number of rows removed.
+		*/
+		size_t dedupe(const std::vector<int>& KeyCols = {});
+
+		/*
+			VLOOKUP without formulas: the value of KeyCol (relative) of each row is looked up in the first column of Lookup.
+			Columns LookupCols of the first matching row (relative to Lookup, all except the first if empty) are written
+			to the columns starting at DestCol (relative, right after the range if negative); rows without a match are emptied.
+			Returns the number of rows that matched.
+		*/
+		size_t join(
+			int KeyCol,
+			const CRangeBase& Lookup,
+			std::vector<int> LookupCols = {},
+			int DestCol = -1);
+
+		//Lookup is in "Sheet!A1:B2" format
+		size_t join(
+			int KeyCol,
+			const wxString& Lookup,
+			std::vector<int> LookupCols = {},
+			int DestCol = -1);
+
+		/*
+			One row per distinct combination of KeyCols (in order of first appearance) followed by the Aggregates.
+			Result is written with a header row into a new worksheet, which is returned.
+			Each group is summarized by ComputeStats, the same way as stats().
+		*/
+		CWorksheetBase* groupby(
+			const std::vector<int>& KeyCols,
+			const std::vector<Aggregate>& Aggregates,
+			const std::wstring& SheetName = L"Summary") const;
+
+
 	protected:
 		//AB15 to AB and 15
 		std::pair<wxString, wxString>
@@ -0,0 +1,13 @@
+#include "rangeviews.h"
+
+#include "worksheetbase.h"
+
+
+
+namespace grid
+{
+	wxString CellRef::value() const
+	{
+		return m_WS->GetTable()->GetValue(m_Row, m_Col);
+	}
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <ranges>
+#include <cstddef>
+#include <type_traits>
+
+#include <wx/wx.h>
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	class CWorksheetBase;
+
+	//A cell of the worksheet, value is only read when requested
+	class DLLGRID CellRef
+	{
+	public:
+		CellRef() = default;
+		CellRef(const CWorksheetBase* ws, int row, int col) :
+			m_WS{ ws }, m_Row{ row }, m_Col{ col } {}
+
+		//relative to the worksheet
+		int row() const {
+			return m_Row;
+		}
+
+		//relative to the worksheet
+		int col() const {
+			return m_Col;
+		}
+
+		//not trimmed (unlike CRangeBase::get)
+		wxString value() const;
+
+	private:
+		const CWorksheetBase* m_WS{ nullptr };
+		int m_Row{ 0 }, m_Col{ 0 };
+	};
+
+
+
+	/*
+		Random access view whose elements are generated from their position by Gen.
+		Nothing is stored or allocated, iterators only hold a copy of Gen and a position.
+	*/
+	template<typename Gen>
+	class GenView : public std::ranges::view_interface<GenView<Gen>>
+	{
+	public:
+		using value_type = std::invoke_result_t<const Gen&, std::ptrdiff_t>;
+
+		class iterator
+		{
+		public:
+			using iterator_concept = std::random_access_iterator_tag;
+			using iterator_category = std::input_iterator_tag; //elements are returned by value
+			using value_type = std::invoke_result_t<const Gen&, std::ptrdiff_t>;
+			using difference_type = std::ptrdiff_t;
+
+			iterator() = default;
+			iterator(const Gen& gen, difference_type pos) : m_Gen{ gen }, m_Pos{ pos } {}
+
+			value_type operator*() const {
+				return m_Gen(m_Pos);
+			}
+
+			value_type operator[](difference_type n) const {
+				return m_Gen(m_Pos + n);
+			}
+
+			iterator& operator++() {
+				++m_Pos;
+				return *this;
+			}
+
+			iterator operator++(int) {
+				auto Temp = *this;
+				++m_Pos;
+				return Temp;
+			}
+
+			iterator& operator--() {
+				--m_Pos;
+				return *this;
+			}
+
+			iterator operator--(int) {
+				auto Temp = *this;
+				--m_Pos;
+				return Temp;
+			}
+
+			iterator& operator+=(difference_type n) {
+				m_Pos += n;
+				return *this;
+			}
+
+			iterator& operator-=(difference_type n) {
+				m_Pos -= n;
+				return *this;
+			}
+
+			friend iterator operator+(iterator it, difference_type n) {
+				return it += n;
+			}
+
+			friend iterator operator+(difference_type n, iterator it) {
+				return it += n;
+			}
+
+			friend iterator operator-(iterator it, difference_type n) {
+				return it -= n;
+			}
+
+			friend difference_type operator-(const iterator& lhs, const iterator& rhs) {
+				return lhs.m_Pos - rhs.m_Pos;
+			}
+
+			friend bool operator==(const iterator& lhs, const iterator& rhs) {
+				return lhs.m_Pos == rhs.m_Pos;
+			}
+
+			friend auto operator<=>(const iterator& lhs, const iterator& rhs) {
+				return lhs.m_Pos <=> rhs.m_Pos;
+			}
+
+		private:
+			Gen m_Gen{};
+			difference_type m_Pos{ 0 };
+		};
+
+	public:
+		GenView() = default;
+		GenView(const Gen& gen, std::ptrdiff_t size) : m_Gen{ gen }, m_Size{ size } {}
+
+		iterator begin() const {
+			return iterator(m_Gen, 0);
+		}
+
+		iterator end() const {
+			return iterator(m_Gen, m_Size);
+		}
+
+		size_t size() const {
+			return (size_t)m_Size;
+		}
+
+	private:
+		Gen m_Gen{};
+		std::ptrdiff_t m_Size{ 0 };
+	};
+
+
+
+	//cells on a line starting from (m_Row, m_Col) advancing by (m_DRow, m_DCol)
+	struct LineGen
+	{
+		const CWorksheetBase* m_WS{ nullptr };
+		int m_Row{ 0 }, m_Col{ 0 };
+		int m_DRow{ 0 }, m_DCol{ 0 };
+
+		CellRef operator()(std::ptrdiff_t i) const {
+			return CellRef(m_WS, m_Row + (int)i * m_DRow, m_Col + (int)i * m_DCol);
+		}
+	};
+
+	//a single row or column of a range
+	using LineView = GenView<LineGen>;
+
+
+	struct RowsGen
+	{
+		const CWorksheetBase* m_WS{ nullptr };
+		int m_Row0{ 0 }, m_Col0{ 0 }, m_NCols{ 0 };
+
+		LineView operator()(std::ptrdiff_t i) const {
+			return LineView(LineGen{ m_WS, m_Row0 + (int)i, m_Col0, 0, 1 }, m_NCols);
+		}
+	};
+
+
+	struct ColsGen
+	{
+		const CWorksheetBase* m_WS{ nullptr };
+		int m_Row0{ 0 }, m_Col0{ 0 }, m_NRows{ 0 };
+
+		LineView operator()(std::ptrdiff_t i) const {
+			return LineView(LineGen{ m_WS, m_Row0, m_Col0 + (int)i, 1, 0 }, m_NRows);
+		}
+	};
+
+
+	//row-major
+	struct CellsGen
+	{
+		const CWorksheetBase* m_WS{ nullptr };
+		int m_Row0{ 0 }, m_Col0{ 0 }, m_NCols{ 1 };
+
+		CellRef operator()(std::ptrdiff_t i) const {
+			return CellRef(m_WS, m_Row0 + (int)(i / m_NCols), m_Col0 + (int)(i % m_NCols));
+		}
+	};
+
+	using RowsView = GenView<RowsGen>;
+	using ColsView = GenView<ColsGen>;
+	using CellsView = GenView<CellsGen>;
+
+	static_assert(std::ranges::view<CellsView> && std::ranges::random_access_range<CellsView>);
+	static_assert(std::ranges::view<RowsView> && std::ranges::random_access_range<RowsView>);
+}
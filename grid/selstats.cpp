@@ -0,0 +1,268 @@
+#include "selstats.h"
+
+#include <vector>
+#include <algorithm>
+
+#include "worksheetbase.h"
+
+
+wxDEFINE_EVENT(ssEVT_WS_SELSTATS, grid::CSelStatsEvent);
+
+
+namespace grid
+{
+	//strips smaller than this are computed on the UI thread
+	constexpr size_t SYNCLIMIT = 4096;
+
+	//cancellation is checked after each chunk
+	constexpr size_t CHUNKSIZE = 65536;
+
+
+	CSelectionStats::CSelectionStats(CWorksheetBase* ws) :m_WS{ ws }
+	{
+	}
+
+
+	CSelectionStats::~CSelectionStats() = default;
+
+
+	void CSelectionStats::Update(const wxGridCellCoords& TL, const wxGridCellCoords& BR)
+	{
+		if (m_HasBlock && TL == m_TL && BR == m_BR)
+			return;
+
+		Job job;
+		job.m_TL = TL;
+		job.m_BR = BR;
+
+		bool Grows = m_HasBlock && !m_Stale &&
+			TL.GetRow() <= m_TL.GetRow() && TL.GetCol() <= m_TL.GetCol() &&
+			BR.GetRow() >= m_BR.GetRow() && BR.GetCol() >= m_BR.GetCol();
+
+		if (Grows)
+		{
+			int Left = TL.GetCol(), Right = BR.GetCol();
+
+			//rows above and below span the whole width
+			if (TL.GetRow() < m_TL.GetRow())
+				Read(TL, { m_TL.GetRow() - 1, Right }, job.m_Cells);
+
+			if (BR.GetRow() > m_BR.GetRow())
+				Read({ m_BR.GetRow() + 1, Left }, BR, job.m_Cells);
+
+			if (Left < m_TL.GetCol())
+				Read({ m_TL.GetRow(), Left }, { m_BR.GetRow(), m_TL.GetCol() - 1 }, job.m_Cells);
+
+			if (Right > m_BR.GetCol())
+				Read({ m_TL.GetRow(), m_BR.GetCol() + 1 }, { m_BR.GetRow(), Right }, job.m_Cells);
+		}
+		else
+		{
+			Cancel();
+			Read(TL, BR, job.m_Cells);
+		}
+
+		job.m_Cells.Close();
+		job.m_Generation = m_Generation;
+
+		m_TL = TL;
+		m_BR = BR;
+		m_HasBlock = true;
+
+		if (m_NPending == 0 && job.m_Cells.size() < SYNCLIMIT)
+		{
+			m_Stats.Merge(*Compute(job, {}));
+			Publish(TL, BR);
+		}
+		else
+		{
+			m_NPending++;
+			Post(std::move(job));
+		}
+	}
+
+
+	void CSelectionStats::Clear()
+	{
+		Cancel();
+		m_HasBlock = false;
+
+		Publish({}, {});
+	}
+
+
+	void CSelectionStats::Invalidate()
+	{
+		if (!m_HasBlock || m_Stale)
+			return;
+
+		Cancel();
+		m_Stale = true;
+
+		//a bulk edit calls this many times
+		m_WS->CallAfter([this]
+		{
+			if (!m_Stale)
+				return;
+
+			m_Stale = false;
+
+			if (m_HasBlock)
+			{
+				m_HasBlock = false;
+				Update(m_TL, m_BR);
+			}
+		});
+	}
+
+
+	void CSelectionStats::Cancel()
+	{
+		m_Generation++;
+
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Jobs.clear();
+		}
+
+		m_Stats = {};
+		m_NPending = 0;
+		m_Stale = false;
+	}
+
+
+	void CSelectionStats::Read(
+		const wxGridCellCoords& TL,
+		const wxGridCellCoords& BR,
+		NarrowCells& Cells) const
+	{
+		const auto& Content = m_WS->GetChangedCells_Content();
+		auto Table = m_WS->GetTable();
+
+		int Left = TL.GetCol(), Right = BR.GetCol();
+
+		//content is ordered by row then column, columns outside the block are skipped
+		auto it = Content.lower_bound(TL);
+		while (it != Content.end() && it->GetRow() <= BR.GetRow())
+		{
+			int Row = it->GetRow(), Col = it->GetCol();
+
+			if (Col < Left)
+			{
+				it = Content.lower_bound({ Row, Left });
+				continue;
+			}
+
+			if (Col > Right)
+			{
+				it = Content.lower_bound({ Row + 1, Left });
+				continue;
+			}
+
+			wxString Value = Table->GetValue(Row, Col);
+			if (!Value.empty())
+				Cells.Append(Value);
+
+			++it;
+		}
+	}
+
+
+	std::optional<SelStats> CSelectionStats::Compute(const Job& job, std::stop_token Token) const
+	{
+		const auto& Cells = job.m_Cells;
+
+		SelStats Result;
+		Result.m_Count = Cells.size();
+
+		std::vector<double> Values;
+		Values.reserve(std::min(Cells.size(), CHUNKSIZE));
+
+		for (size_t First = 0; First < Cells.size(); First += CHUNKSIZE)
+		{
+			if (Token.stop_requested() || job.m_Generation != m_Generation)
+				return std::nullopt;
+
+			size_t Last = std::min(First + CHUNKSIZE, Cells.size());
+
+			Values.clear();
+			for (size_t i = First; i < Last; ++i)
+			{
+				double Value{};
+				if (ParseNumber(Cells.begin(i), Cells.end(i), Value))
+					Values.push_back(Value);
+			}
+
+			Result.m_Numeric.Merge(ComputeStats(Values));
+		}
+
+		return Result;
+	}
+
+
+	void CSelectionStats::Run(std::stop_token Token)
+	{
+		while (!Token.stop_requested())
+		{
+			Job job;
+
+			{
+				std::unique_lock lock(m_Mutex);
+				if (!m_CV.wait(lock, Token, [this] { return !m_Jobs.empty(); }))
+					return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop_front();
+			}
+
+			auto Delta = Compute(job, Token);
+			if (!Delta)
+				continue;
+
+			//CallAfter is safe to use from another thread
+			m_WS->CallAfter([this, Generation = job.m_Generation, Delta = *Delta, TL = job.m_TL, BR = job.m_BR]
+			{
+				OnComputed(Generation, Delta, TL, BR);
+			});
+		}
+	}
+
+
+	void CSelectionStats::Post(Job job)
+	{
+		if (!m_Worker.joinable())
+			m_Worker = std::jthread([this](std::stop_token Token) { Run(Token); });
+
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Jobs.push_back(std::move(job));
+		}
+
+		m_CV.notify_one();
+	}
+
+
+	void CSelectionStats::OnComputed(
+		size_t Generation,
+		const SelStats& Delta,
+		wxGridCellCoords TL,
+		wxGridCellCoords BR)
+	{
+		//superseded by a block that is not an extension
+		if (Generation != m_Generation)
+			return;
+
+		m_NPending--;
+		m_Stats.Merge(Delta);
+
+		Publish(TL, BR);
+	}
+
+
+	void CSelectionStats::Publish(const wxGridCellCoords& TL, const wxGridCellCoords& BR)
+	{
+		CSelStatsEvent evt(ssEVT_WS_SELSTATS, m_WS->GetId(), m_Stats, TL, BR);
+		evt.SetEventObject(m_WS);
+		m_WS->ProcessWindowEvent(evt);
+	}
+}
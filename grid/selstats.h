@@ -0,0 +1,139 @@
+#pragma once
+
+#include <deque>
+#include <optional>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+#include <wx/wx.h>
+#include <wx/grid.h>
+
+#include "aggregates.h"
+#include "narrowcells.h"
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	class CWorksheetBase;
+
+	struct SelStats
+	{
+		size_t m_Count{ 0 }; //non-empty cells
+		Stats m_Numeric; //numeric cells
+
+		void Merge(const SelStats& Other)
+		{
+			m_Count += Other.m_Count;
+			m_Numeric.Merge(Other.m_Numeric);
+		}
+	};
+
+
+	class DLLGRID CSelStatsEvent : public wxCommandEvent
+	{
+	public:
+		CSelStatsEvent(
+			wxEventType EventType = wxEVT_NULL,
+			int id = 0,
+			const SelStats& stats = {},
+			const wxGridCellCoords& TL = {},
+			const wxGridCellCoords& BR = {}) :
+			wxCommandEvent(EventType, id), m_Stats{ stats }, m_TL{ TL }, m_BR{ BR } {}
+
+		wxEvent* Clone() const override {
+			return new CSelStatsEvent(*this);
+		}
+
+		const SelStats& GetStats() const {
+			return m_Stats;
+		}
+
+		//the block the stats belong to (invalid coords if there is no selection)
+		wxGridCellCoords GetTopLeft() const {
+			return m_TL;
+		}
+
+		wxGridCellCoords GetBottomRight() const {
+			return m_BR;
+		}
+
+	private:
+		SelStats m_Stats;
+		wxGridCellCoords m_TL, m_BR;
+	};
+
+
+
+	/*
+		Statistics of the selected block of a worksheet.
+		When the block grows only the new strips are read, otherwise the block is read again.
+		Large strips are parsed on a worker thread, a newer request cancels the ones that are superseded.
+		Results are published as ssEVT_WS_SELSTATS from the UI thread.
+	*/
+	class CSelectionStats
+	{
+	public:
+		CSelectionStats(CWorksheetBase* ws);
+		~CSelectionStats();
+
+		void Update(const wxGridCellCoords& TL, const wxGridCellCoords& BR);
+
+		//cancels pending work and publishes empty stats
+		void Clear();
+
+		//cell values changed, the block is read again once control returns to the event loop
+		void Invalidate();
+
+		//stats of the last published block
+		const SelStats& GetStats() const {
+			return m_Stats;
+		}
+
+	private:
+		struct Job
+		{
+			size_t m_Generation;
+			NarrowCells m_Cells;
+			wxGridCellCoords m_TL, m_BR; //block after the job is merged
+		};
+
+		//appends the populated cells of the block (empty cells do not contribute)
+		void Read(const wxGridCellCoords& TL, const wxGridCellCoords& BR, NarrowCells& Cells) const;
+
+		//nullopt if cancelled
+		std::optional<SelStats> Compute(const Job& job, std::stop_token Token) const;
+
+		void Run(std::stop_token Token);
+		void Post(Job job);
+		void Cancel();
+		void OnComputed(size_t Generation, const SelStats& Delta, wxGridCellCoords TL, wxGridCellCoords BR);
+		void Publish(const wxGridCellCoords& TL, const wxGridCellCoords& BR);
+
+	private:
+		CWorksheetBase* m_WS;
+
+		//requested block, all jobs up to it have been posted
+		wxGridCellCoords m_TL, m_BR;
+		bool m_HasBlock{ false };
+		bool m_Stale{ false };
+
+		SelStats m_Stats;
+		size_t m_NPending{ 0 };
+
+		std::atomic<size_t> m_Generation{ 0 };
+
+		std::mutex m_Mutex;
+		std::condition_variable_any m_CV;
+		std::deque<Job> m_Jobs;
+
+		//started with the first large job
+		std::jthread m_Worker;
+	};
+}
+
+
+//statistics of the selection changed
+DLLGRID wxDECLARE_EVENT(ssEVT_WS_SELSTATS, grid::CSelStatsEvent);
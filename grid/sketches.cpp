@@ -0,0 +1,188 @@
+#include "sketches.h"
+
+#include <bit>
+#include <cmath>
+#include <algorithm>
+
+
+namespace grid
+{
+	//values are merged into the centroids once this many are buffered
+	constexpr size_t TDIGEST_BUFFER = 4096;
+
+
+	std::uint64_t HashBytes(const char* Begin, const char* End)
+	{
+		//FNV-1a followed by the splitmix64 finalizer
+		std::uint64_t h = 0xCBF29CE484222325ULL;
+		for (const char* p = Begin; p < End; ++p)
+			h = (h ^ (unsigned char)*p) * 0x100000001B3ULL;
+
+		h ^= h >> 30;
+		h *= 0xBF58476D1CE4E5B9ULL;
+		h ^= h >> 27;
+		h *= 0x94D049BB133111EBULL;
+		h ^= h >> 31;
+
+		return h;
+	}
+
+
+
+
+	CHyperLogLog::CHyperLogLog() :m_Registers(size_t{ 1 } << PRECISION, 0)
+	{
+	}
+
+
+	void CHyperLogLog::Add(std::uint64_t Hash)
+	{
+		size_t Index = Hash >> (64 - PRECISION);
+
+		//position of the first set bit of the remaining bits, bounded if all are 0
+		std::uint64_t Rest = (Hash << PRECISION) | (std::uint64_t{ 1 } << (PRECISION - 1));
+		auto Rank = (std::uint8_t)(std::countl_zero(Rest) + 1);
+
+		m_Registers[Index] = std::max(m_Registers[Index], Rank);
+	}
+
+
+	void CHyperLogLog::Merge(const CHyperLogLog& Other)
+	{
+		for (size_t i = 0; i < m_Registers.size(); ++i)
+			m_Registers[i] = std::max(m_Registers[i], Other.m_Registers[i]);
+	}
+
+
+	double CHyperLogLog::Estimate() const
+	{
+		double m = (double)m_Registers.size();
+
+		double Sum = 0;
+		size_t Zeros = 0;
+		for (auto Reg : m_Registers)
+		{
+			Sum += std::ldexp(1.0, -(int)Reg);
+			Zeros += Reg == 0;
+		}
+
+		double Alpha = 0.7213 / (1.0 + 1.079 / m);
+		double E = Alpha * m * m / Sum;
+
+		//linear counting is more accurate for small cardinalities
+		if (E <= 2.5 * m && Zeros > 0)
+			E = m * std::log(m / (double)Zeros);
+
+		return E;
+	}
+
+
+
+
+	CTDigest::CTDigest(double Compression) :m_Compression{ Compression }
+	{
+	}
+
+
+	void CTDigest::Add(double Value)
+	{
+		if (std::isnan(Value))
+			return;
+
+		m_Buffer.push_back({ Value, 1.0 });
+		m_Min = std::min(m_Min, Value);
+		m_Max = std::max(m_Max, Value);
+
+		if (m_Buffer.size() >= TDIGEST_BUFFER)
+			Compress();
+	}
+
+
+	void CTDigest::Merge(const CTDigest& Other)
+	{
+		m_Buffer.insert(m_Buffer.end(), Other.m_Centroids.begin(), Other.m_Centroids.end());
+		m_Buffer.insert(m_Buffer.end(), Other.m_Buffer.begin(), Other.m_Buffer.end());
+
+		m_Min = std::min(m_Min, Other.m_Min);
+		m_Max = std::max(m_Max, Other.m_Max);
+
+		Compress();
+	}
+
+
+	void CTDigest::Compress()
+	{
+		if (m_Buffer.empty())
+			return;
+
+		m_Buffer.insert(m_Buffer.end(), m_Centroids.begin(), m_Centroids.end());
+		std::sort(m_Buffer.begin(), m_Buffer.end(), [](const Centroid& a, const Centroid& b)
+		{
+			return a.m_Mean < b.m_Mean;
+		});
+
+		double Total = 0;
+		for (const auto& c : m_Buffer)
+			Total += c.m_Weight;
+
+		m_Centroids.clear();
+		m_Centroids.push_back(m_Buffer[0]);
+
+		//a centroid at quantile q can hold up to 4*Total*q*(1-q)/Compression
+		double SoFar = 0;
+		for (size_t i = 1; i < m_Buffer.size(); ++i)
+		{
+			auto& Last = m_Centroids.back();
+			const auto& Next = m_Buffer[i];
+
+			double Proposed = Last.m_Weight + Next.m_Weight;
+			double q = (SoFar + Proposed / 2) / Total;
+
+			if (Proposed <= 4 * Total * q * (1 - q) / m_Compression)
+			{
+				Last.m_Mean += (Next.m_Mean - Last.m_Mean) * Next.m_Weight / Proposed;
+				Last.m_Weight = Proposed;
+			}
+			else
+			{
+				SoFar += Last.m_Weight;
+				m_Centroids.push_back(Next);
+			}
+		}
+
+		m_Buffer.clear();
+	}
+
+
+	double CTDigest::Quantile(double q)
+	{
+		Compress();
+
+		if (m_Centroids.empty())
+			return std::numeric_limits<double>::quiet_NaN();
+
+		double Total = 0;
+		for (const auto& c : m_Centroids)
+			Total += c.m_Weight;
+
+		double Target = std::clamp(q, 0.0, 1.0) * Total;
+
+		//mean of a centroid is placed at the middle of its weight, interpolated in between
+		double PrevMid = 0, PrevMean = m_Min, Cum = 0;
+		for (const auto& c : m_Centroids)
+		{
+			double Mid = Cum + c.m_Weight / 2;
+			if (Target < Mid)
+				return PrevMean + (c.m_Mean - PrevMean) * (Target - PrevMid) / (Mid - PrevMid);
+
+			PrevMid = Mid;
+			PrevMean = c.m_Mean;
+			Cum += c.m_Weight;
+		}
+
+		if (Total <= PrevMid)
+			return m_Max;
+
+		return PrevMean + (m_Max - PrevMean) * (Target - PrevMid) / (Total - PrevMid);
+	}
+}
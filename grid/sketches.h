@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	//64-bit hash of the bytes with well mixed bits (sketches use the high bits)
+	DLLGRID std::uint64_t HashBytes(const char* Begin, const char* End);
+
+
+	/*
+		Estimates the number of distinct values (HyperLogLog, standard error is about 0.8%).
+		Sketches built over parts of the data are merged without loss.
+	*/
+	class DLLGRID CHyperLogLog
+	{
+	public:
+		CHyperLogLog();
+
+		void Add(std::uint64_t Hash);
+		void Merge(const CHyperLogLog& Other);
+
+		double Estimate() const;
+
+	private:
+		static constexpr int PRECISION = 14;
+
+		std::vector<std::uint8_t> m_Registers;
+	};
+
+
+
+	/*
+		Approximate quantiles (merging t-digest), accuracy is highest near the tails.
+		Compression bounds the number of centroids kept.
+	*/
+	class DLLGRID CTDigest
+	{
+	public:
+		CTDigest(double Compression = 100);
+
+		//NaN is ignored
+		void Add(double Value);
+		void Merge(const CTDigest& Other);
+
+		//q in [0, 1], NaN if no values were added
+		double Quantile(double q);
+
+	private:
+		struct Centroid
+		{
+			double m_Mean;
+			double m_Weight;
+		};
+
+		void Compress();
+
+	private:
+		double m_Compression;
+
+		std::vector<Centroid> m_Centroids; //sorted by mean
+		std::vector<Centroid> m_Buffer; //not yet merged
+
+		double m_Min{ std::numeric_limits<double>::infinity() };
+		double m_Max{ -std::numeric_limits<double>::infinity() };
+	};
+}
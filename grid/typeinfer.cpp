@@ -0,0 +1,154 @@
+#include "typeinfer.h"
+
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <iterator>
+#include <string_view>
+
+#include "parallel.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define GRID_SSE2
+	#include <emmintrin.h>
+#endif
+
+
+
+namespace grid
+{
+	//characters a cell of a type can have
+	struct Alphabet
+	{
+		bool m_Digits;
+		std::string_view m_Chars;
+	};
+
+
+	static Alphabet GetAlphabet(CELLTYPE Type)
+	{
+		switch (Type)
+		{
+		case CELLTYPE::BOOLEAN:
+			return { false, "trueTRUEfalsFALS \t\r\n\v\f" };
+
+		//an integer column can still become float
+		case CELLTYPE::INTEGER:
+		case CELLTYPE::FLOAT:
+			return { true, "+-.eE \t\r\n\v\f" };
+
+		case CELLTYPE::DATE:
+			return { true, "-/.:T \t\r\n\v\f" };
+
+		default:
+			return { true, {} };
+		}
+	}
+
+
+	static bool InAlphabet(std::string_view Chars, const Alphabet& Alpha)
+	{
+		size_t i = 0, N = Chars.size();
+
+#ifdef GRID_SSE2
+		//bytes >= 0x80 are negative, therefore never in the digit range
+		const __m128i Lo = _mm_set1_epi8('0' - 1), Hi = _mm_set1_epi8('9' + 1);
+
+		__m128i Allowed[32];
+		size_t NAllowed = std::min(Alpha.m_Chars.size(), std::size(Allowed));
+		for (size_t k = 0; k < NAllowed; ++k)
+			Allowed[k] = _mm_set1_epi8(Alpha.m_Chars[k]);
+
+		for (; i + 16 <= N; i += 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(Chars.data() + i));
+
+			__m128i Ok = _mm_setzero_si128();
+			if (Alpha.m_Digits)
+				Ok = _mm_and_si128(_mm_cmpgt_epi8(v, Lo), _mm_cmplt_epi8(v, Hi));
+
+			for (size_t k = 0; k < NAllowed; ++k)
+				Ok = _mm_or_si128(Ok, _mm_cmpeq_epi8(v, Allowed[k]));
+
+			if (_mm_movemask_epi8(Ok) != 0xFFFF)
+				return false;
+		}
+#endif
+
+		for (; i < N; ++i)
+		{
+			char c = Chars[i];
+			bool IsDigit = c >= '0' && c <= '9';
+
+			if (!(Alpha.m_Digits && IsDigit) && Alpha.m_Chars.find(c) == std::string_view::npos)
+				return false;
+		}
+
+		return true;
+	}
+
+
+
+
+	CELLTYPE InferType(const NarrowCells& Cells, size_t SampleSize)
+	{
+		size_t N = Cells.size();
+
+		auto Classify = [&](size_t i)
+		{
+			return ClassifyCell(Cells.begin(i), Cells.end(i));
+		};
+
+		//small columns are classified exactly
+		if (N <= SampleSize)
+		{
+			CELLTYPE Type = CELLTYPE::EMPTY;
+			for (size_t i = 0; i < N && Type != CELLTYPE::TEXT; ++i)
+				Type = WidenType(Type, Classify(i));
+
+			return Type;
+		}
+
+		//fixed seed, the same cells give the same guess
+		std::minstd_rand Engine((unsigned)N);
+		std::uniform_int_distribution<size_t> Dist(0, N - 1);
+
+		CELLTYPE Guess = CELLTYPE::EMPTY;
+		for (size_t k = 0; k < SampleSize && Guess != CELLTYPE::TEXT; ++k)
+			Guess = WidenType(Guess, Classify(Dist(Engine)));
+
+		//text cannot be widened further
+		if (Guess == CELLTYPE::TEXT)
+			return Guess;
+
+		//a single character outside of the alphabet makes a cell of another type, and the column text
+		if (Guess != CELLTYPE::EMPTY && !InAlphabet(Cells.m_Chars, GetAlphabet(Guess)))
+			return CELLTYPE::TEXT;
+
+		std::mutex Mutex;
+		std::atomic<bool> IsText{ false };
+		CELLTYPE Result = Guess;
+
+		ParallelFor(N, [&](size_t First, size_t Last)
+		{
+			CELLTYPE Type = Guess;
+			for (size_t i = First; i < Last; ++i)
+			{
+				Type = WidenType(Type, Classify(i));
+
+				//checked every 1024 cells
+				if (Type == CELLTYPE::TEXT || ((i & 1023) == 0 && IsText))
+					break;
+			}
+
+			if (Type == CELLTYPE::TEXT)
+				IsText = true;
+
+			std::lock_guard lock(Mutex);
+			Result = WidenType(Result, Type);
+		}, 16384);
+
+		return Result;
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "celltype.h"
+#include "narrowcells.h"
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	/*
+		Type of a column of cells (see WidenType), EMPTY if all cells are empty.
+		A bounded random sample gives a guess, which is then confirmed on all cells:
+		a vectorized scan rejects the guess if any character is not allowed for the type, otherwise cells are classified in parallel.
+	*/
+	DLLGRID CELLTYPE InferType(const NarrowCells& Cells, size_t SampleSize = 512);
+}
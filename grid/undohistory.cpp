@@ -0,0 +1,127 @@
+#include "undohistory.h"
+
+#include "undoredo.h"
+
+
+
+namespace grid
+{
+	UndoHistory::~UndoHistory() = default;
+
+
+	void UndoHistory::push(std::unique_ptr<WSUndoRedoEvent> event)
+	{
+		size_t Size = event->GetMemorySize();
+		m_Bytes += Size;
+
+		size_t WSId = event->GetEventSourceId();
+
+		m_Events.push_back({ std::move(event), Size, WSId });
+		m_Segments[WSId].push_back(std::prev(m_Events.end()));
+	}
+
+
+	std::unique_ptr<WSUndoRedoEvent> UndoHistory::pop()
+	{
+		if (m_Events.empty())
+			return nullptr;
+
+		auto TopIt = std::prev(m_Events.end());
+		Unindex(TopIt, true);
+
+		auto Top = std::move(m_Events.back());
+		m_Events.pop_back();
+
+		m_Bytes -= Top.m_Size;
+
+		return std::move(Top.m_Event);
+	}
+
+
+	std::unique_ptr<WSUndoRedoEvent> UndoHistory::pop_oldest()
+	{
+		if (m_Events.empty())
+			return nullptr;
+
+		Unindex(m_Events.begin(), false);
+
+		auto Oldest = std::move(m_Events.front());
+		m_Events.pop_front();
+
+		m_Bytes -= Oldest.m_Size;
+
+		return std::move(Oldest.m_Event);
+	}
+
+
+	WSUndoRedoEvent* UndoHistory::top() const
+	{
+		return m_Events.empty() ? nullptr : m_Events.back().m_Event.get();
+	}
+
+
+	size_t UndoHistory::erase_worksheet(size_t WSId)
+	{
+		auto SegIt = m_Segments.find(WSId);
+		if (SegIt == m_Segments.end())
+			return 0;
+
+		size_t NErased = SegIt->second.size();
+
+		for (auto it : SegIt->second)
+		{
+			m_Bytes -= it->m_Size;
+			m_Events.erase(it);
+		}
+
+		m_Segments.erase(SegIt);
+
+		return NErased;
+	}
+
+
+	size_t UndoHistory::count(size_t WSId) const
+	{
+		auto SegIt = m_Segments.find(WSId);
+		return SegIt != m_Segments.end() ? SegIt->second.size() : 0;
+	}
+
+
+	void UndoHistory::UpdateTopSize()
+	{
+		if (m_Events.empty())
+			return;
+
+		auto& Top = m_Events.back();
+		m_Bytes -= Top.m_Size;
+
+		Top.m_Size = Top.m_Event->GetMemorySize();
+		m_Bytes += Top.m_Size;
+	}
+
+
+	void UndoHistory::clear()
+	{
+		m_Events.clear();
+		m_Segments.clear();
+		m_Bytes = 0;
+	}
+
+
+	void UndoHistory::Unindex(EntryIter it, bool Newest)
+	{
+		auto SegIt = m_Segments.find(it->m_WSId);
+		if (SegIt == m_Segments.end())
+			return;
+
+		auto& Segment = SegIt->second;
+		
+		if (Newest)
+			Segment.pop_back();
+		else
+			Segment.pop_front();
+
+		if (Segment.empty())
+			m_Segments.erase(SegIt);
+	}
+}
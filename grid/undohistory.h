@@ -0,0 +1,84 @@
+#pragma once
+
+#include <list>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	class WSUndoRedoEvent;
+
+	/*
+		Undo or redo history, newest event is at the top.
+		Keeps track of the memory used by the events so that the oldest ones can be evicted.
+		
+		Events are kept in a single list in the order they happened and each worksheet 
+		indexes its own events (segment) so that they can be removed without visiting the others.
+	*/
+	class DLLGRID UndoHistory
+	{
+		struct Entry
+		{
+			std::unique_ptr<WSUndoRedoEvent> m_Event;
+			size_t m_Size; //memory size when the event was pushed
+			size_t m_WSId; //id of the worksheet the event belongs to
+		};
+
+		using EntryIter = std::list<Entry>::iterator;
+
+	public:
+		UndoHistory() = default;
+		~UndoHistory();
+
+		UndoHistory(const UndoHistory&) = delete;
+		UndoHistory& operator=(const UndoHistory&) = delete;
+
+		void push(std::unique_ptr<WSUndoRedoEvent> event);
+
+		//removes and returns the newest event
+		std::unique_ptr<WSUndoRedoEvent> pop();
+
+		//removes and returns the oldest event
+		std::unique_ptr<WSUndoRedoEvent> pop_oldest();
+
+		//newest event
+		WSUndoRedoEvent* top() const;
+
+		//Removes all events of the worksheet, returns the number of events removed
+		size_t erase_worksheet(size_t WSId);
+
+		//to be called when the top event changed its contents
+		void UpdateTopSize();
+
+		void clear();
+
+		bool empty() const {
+			return m_Events.empty();
+		}
+
+		size_t size() const {
+			return m_Events.size();
+		}
+
+		//number of events belonging to the worksheet
+		size_t count(size_t WSId) const;
+
+		//total memory size of the events in bytes
+		size_t GetMemorySize() const {
+			return m_Bytes;
+		}
+
+	private:
+		//removes the entry from its worksheet's segment, entry must be the newest or oldest of the segment
+		void Unindex(EntryIter it, bool Newest);
+
+	private:
+		std::list<Entry> m_Events;
+		std::unordered_map<size_t, std::deque<EntryIter>> m_Segments;
+		size_t m_Bytes{ 0 };
+	};
+}
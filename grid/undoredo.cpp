@@ -8,14 +8,92 @@
 
 namespace grid
 {
+	WorksheetRef::WorksheetRef(CWorksheetBase* worksheet)
+	{
+		if (!worksheet)
+			return;
+
+		m_Id = worksheet->GetWSId();
+		m_Workbook = worksheet->GetWorkbook();
+
+		if (!m_Workbook)
+			m_Worksheet = worksheet;
+	}
+
+
+	CWorksheetBase* WorksheetRef::get() const
+	{
+		return m_Workbook ? m_Workbook->GetWorksheetById(m_Id) : m_Worksheet;
+	}
+
+
+
+
+	bool WSUndoRedoEvent::MergeWith(const WSUndoRedoEvent& Next)
+	{
+		if (GetEventSourceId() != Next.GetEventSourceId() || !Merge(Next))
+			return false;
+
+		m_TimeStamp = Next.m_TimeStamp;
+
+		return true;
+	}
+
 
-	
 	void WSUndoRedoEvent::ShowWorksheet()
 	{
-		auto workbook = m_WSBase->GetWorkbook();
-		if (m_WSBase != workbook->GetActiveWS())
-			workbook->ShowWorksheet(m_WSBase);
+		auto worksheet = m_WSBase.get();
+		auto workbook = m_WSBase.GetWorkbook();
+
+		if (!worksheet || !workbook)
+			return;
+
+		//shown once when replay ends
+		if (workbook->IsReplaying())
+		{
+			workbook->RecordReplaySheet(worksheet);
+			return;
+		}
 
+		if (worksheet != workbook->GetActiveWS())
+			workbook->ShowWorksheet(worksheet);
+	}
+
+
+	void WSUndoRedoEvent::SelectBlock(const wxGridCellCoords& TL, const wxGridCellCoords& BR)
+	{
+		auto worksheet = m_WSBase.get();
+		if (!worksheet)
+			return;
+
+		auto workbook = m_WSBase.GetWorkbook();
+		if (workbook && workbook->IsReplaying())
+		{
+			workbook->RecordReplayBlock(worksheet, TL, BR);
+			return;
+		}
+
+		worksheet->SelectBlock(TL, BR);
+	}
+
+
+	void WSUndoRedoEvent::GoToCell(int row, int col)
+	{
+		auto worksheet = m_WSBase.get();
+		if (!worksheet)
+			return;
+
+		auto workbook = m_WSBase.GetWorkbook();
+		if (workbook && workbook->IsReplaying())
+		{
+			workbook->RecordReplayBlock(worksheet, { row, col }, { row, col });
+			return;
+		}
+
+		if (worksheet->IsSelection())
+			worksheet->ClearSelection();
+
+		worksheet->GoToCell(row, col);
 	}
 
 
@@ -26,25 +104,23 @@ namespace grid
 
 	void CellDataChanged::Undo()
 	{
-		ShowWorksheet();
+		auto worksheet = m_WSBase.get();
 
-		m_WSBase->SetCellValue(m_row, m_col, m_InitVal);
+		ShowWorksheet();
 
-		if (m_WSBase->IsSelection())
-			m_WSBase->ClearSelection();
+		worksheet->SetCellValue(m_row, m_col, m_InitVal);
 
-		m_WSBase->GoToCell(m_row, m_col);
+		GoToCell(m_row, m_col);
 	}
 
 	void CellDataChanged::Redo()
 	{
-		ShowWorksheet();
+		auto worksheet = m_WSBase.get();
 
-		m_WSBase->SetCellValue(m_row, m_col, m_LastVal);
-		if (m_WSBase->IsSelection())
-			m_WSBase->ClearSelection();
+		ShowWorksheet();
 
-		m_WSBase->GoToCell(m_row, m_col);
+		worksheet->SetCellValue(m_row, m_col, m_LastVal);
+		GoToCell(m_row, m_col);
 	}
 
 
@@ -68,32 +144,48 @@ namespace grid
 	}
 
 
+	size_t CellDataChanged::GetMemorySize() const
+	{
+		return sizeof(*this) + (m_InitVal.capacity() + m_LastVal.capacity()) * sizeof(wchar_t);
+	}
+
+
+	bool CellDataChanged::Merge(const WSUndoRedoEvent& Next)
+	{
+		auto NextEvt = dynamic_cast<const CellDataChanged*>(&Next);
+		if (!NextEvt || NextEvt->m_row != m_row || NextEvt->m_col != m_col)
+			return false;
+
+		m_LastVal = NextEvt->m_LastVal;
+
+		return true;
+	}
+
+
 
 
 	/*************   Cell Value Changed Event ***************************/
 
 	void CellValueChangedEvent::Undo()
 	{
-		ShowWorksheet();
+		auto worksheet = m_WSBase.get();
 
-		m_WSBase->SetCellValue(m_row, m_col, m_InitVal);
+		ShowWorksheet();
 
-		if (m_WSBase->IsSelection())
-			m_WSBase->ClearSelection();
+		worksheet->SetCellValue(m_row, m_col, m_InitVal);
 
-		m_WSBase->GoToCell(m_row, m_col);
+		GoToCell(m_row, m_col);
 	}
 
 	void CellValueChangedEvent::Redo()
 	{
-		ShowWorksheet();
+		auto worksheet = m_WSBase.get();
 
-		m_WSBase->SetCellValue(m_row, m_col, m_LastVal);
+		ShowWorksheet();
 
-		if (m_WSBase->IsSelection())
-			m_WSBase->ClearSelection();
+		worksheet->SetCellValue(m_row, m_col, m_LastVal);
 
-		m_WSBase->GoToCell(m_row, m_col);
+		GoToCell(m_row, m_col);
 	}
 
 
@@ -113,6 +205,12 @@ namespace grid
 	}
 
 
+	size_t CellValueChangedEvent::GetMemorySize() const
+	{
+		return sizeof(*this) + (m_InitVal.capacity() + m_LastVal.capacity()) * sizeof(wchar_t);
+	}
+
+
 
 
 
@@ -120,25 +218,29 @@ namespace grid
 
 	void CellContentDeleted::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		for (auto elem : m_InitVal)
-			m_WSBase->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
+		for (const auto& elem : m_InitVal.Load())
+			worksheet->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
 
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+		SelectBlock(m_TL, m_BR);
 	}
 
 
 	void CellContentDeleted::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		for (auto elem : m_InitVal)
-			m_WSBase->SetCellValue(elem.GetRow(), elem.GetCol(), wxEmptyString);
+		for (const auto& elem : m_InitVal.Load())
+			worksheet->SetCellValue(elem.GetRow(), elem.GetCol(), wxEmptyString);
 
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+		SelectBlock(m_TL, m_BR);
 	}
 
 
@@ -157,199 +259,242 @@ namespace grid
 	}
 
 
-
-
-
-	/*************   Cell BG Color Changed Event ***************************/
-
-	void CellBGColorChangedEvent::Undo()
+	size_t CellContentDeleted::GetMemorySize() const
 	{
-		ShowWorksheet();
-
-		for (const auto& c : m_InitVal)
-			m_WSBase->SetCellBackgroundColour(c.GetRow(), c.GetCol(), c.GetFormat().GetBackgroundColor());
-
-		m_WSBase->SelectBlock(m_TL, m_BR);
+		return sizeof(*this) + m_InitVal.GetMemorySize();
 	}
 
 
-	void CellBGColorChangedEvent::Redo()
+	void CellContentDeleted::SetInitialCells(std::vector<Cell>&& Cells)
 	{
-		ShowWorksheet();
+		m_InitVal.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
 
-		for (const auto& c : m_LastVal)
-			m_WSBase->SetCellBackgroundColour(c.GetRow(), c.GetCol(), c.GetFormat().GetBackgroundColor());
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
-	}
 
 
-	std::wstring CellBGColorChangedEvent::GetToolTip(bool IsUndo)
-	{
-		std::wstringstream ToolTip;
-		ToolTip << (IsUndo ? "Undo " : "Redo ");
 
-		if (m_TL == m_BR)
-			ToolTip << "background color change in cell " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1;
-		else
-			ToolTip << "background color change in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
-			<< ColNumtoLetters(m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
+	/*************   Format Attributes ***************************/
 
-		return ToolTip.str();
+	wxColour BGColorAttr::Get(const CWorksheetBase* ws, int row, int col)
+	{
+		return ws->GetCellBackgroundColour(row, col);
 	}
 
+	void BGColorAttr::Set(CWorksheetBase* ws, int row, int col, const wxColour& Value)
+	{
+		ws->SetCellBackgroundColour(row, col, Value);
+	}
 
+	std::wstring BGColorAttr::Name(const std::string& Property)
+	{
+		return L"background color change";
+	}
 
 
 
+	wxColour TextColorAttr::Get(const CWorksheetBase* ws, int row, int col)
+	{
+		return ws->GetCellTextColour(row, col);
+	}
 
-	/*************   Text Color Changed Event ***************************/
+	void TextColorAttr::Set(CWorksheetBase* ws, int row, int col, const wxColour& Value)
+	{
+		ws->SetCellTextColour(row, col, Value);
+	}
 
-	void TextColorChangedEvent::Undo()
+	std::wstring TextColorAttr::Name(const std::string& Property)
 	{
-		ShowWorksheet();
+		return L"text color change";
+	}
 
-		for (const auto& cell : m_InitVal)
-			m_WSBase->SetCellTextColour(cell.GetRow(), cell.GetCol(), cell.GetFormat().GetTextColor());
 
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+	wxFont FontAttr::Get(const CWorksheetBase* ws, int row, int col)
+	{
+		return ws->GetCellFont(row, col);
 	}
 
-
-	void TextColorChangedEvent::Redo()
+	void FontAttr::Set(CWorksheetBase* ws, int row, int col, const wxFont& Value)
 	{
-		ShowWorksheet();
-
-		for (const auto& cell : m_LastVal)
-			m_WSBase->SetCellTextColour(cell.GetRow(), cell.GetCol(), cell.GetFormat().GetTextColor());
-
+		ws->SetCellFont(row, col, Value);
+	}
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+	std::wstring FontAttr::Name(const std::string& Property)
+	{
+		return L"text " + wxString(Property).ToStdWstring();
 	}
 
 
-	std::wstring TextColorChangedEvent::GetToolTip(bool IsUndo)
-	{
-		std::wstringstream ToolTip;
-		ToolTip << (IsUndo ? "Undo " : "Redo ");
 
-		if (m_TL == m_BR)
-			ToolTip << "text color change in cell " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1;
-		else
-			ToolTip << "text color change in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
-			<< ColNumtoLetters(m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
+	std::pair<int, int> AlignmentAttr::Get(const CWorksheetBase* ws, int row, int col)
+	{
+		int horiz = 0, vert = 0;
+		ws->GetCellAlignment(row, col, &horiz, &vert);
 
-		return ToolTip.str();
+		return { horiz, vert };
 	}
 
+	void AlignmentAttr::Set(CWorksheetBase* ws, int row, int col, const std::pair<int, int>& Value)
+	{
+		ws->SetCellAlignment(row, col, Value.first, Value.second);
+	}
 
+	std::wstring AlignmentAttr::Name(const std::string& Property)
+	{
+		return L"cell alignment";
+	}
 
 
 
 
 
-	/*************   Font Changed Event ***************************/
+	/*************   Format Changed Event ***************************/
 
-	void FontChangedEvent::Undo()
+	template<typename Attr>
+	void FormatChangedEvent<Attr>::Undo()
 	{
 		ShowWorksheet();
 
-		for (auto cell : m_InitVal)
-			m_WSBase->SetCellFont(cell.GetRow(), cell.GetCol(), cell.GetFormat().GetFont());
-
+		Apply(m_InitVal);
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+		SelectBlock(m_TL, m_BR);
 	}
 
 
-	void FontChangedEvent::Redo()
+	template<typename Attr>
+	void FormatChangedEvent<Attr>::Redo()
 	{
 		ShowWorksheet();
 
-		for (auto cell : m_LastVal)
-			m_WSBase->SetCellFont(cell.GetRow(), cell.GetCol(), cell.GetFormat().GetFont());
+		Apply(m_LastVal);
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+		SelectBlock(m_TL, m_BR);
 	}
 
 
-	std::wstring FontChangedEvent::GetToolTip(bool IsUndo)
+	template<typename Attr>
+	std::wstring FormatChangedEvent<Attr>::GetToolTip(bool IsUndo)
 	{
 		std::wstringstream ToolTip;
-		ToolTip << (IsUndo ? "Undo text " : "Redo text ") << m_FontProperty << " ";
+		ToolTip << (IsUndo ? L"Undo " : L"Redo ") << Attr::Name(m_Property);
 
 		if (m_TL == m_BR)
-			ToolTip << "in cell " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1;
+			ToolTip << " in cell " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1;
 		else
-			ToolTip << "in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
+			ToolTip << " in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
 			<< ColNumtoLetters(m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
 
 		return ToolTip.str();
 	}
 
 
+	template<typename Attr>
+	size_t FormatChangedEvent<Attr>::GetMemorySize() const
+	{
+		return sizeof(*this) + (m_InitVal.capacity() + m_LastVal.capacity()) * sizeof(Run);
+	}
 
 
-	/*************   Cell Alignment Changed Event ***************************/
-
-	
-	void CellAlignmentChangedEvent::Undo()
+	template<typename Attr>
+	bool FormatChangedEvent<Attr>::Merge(const WSUndoRedoEvent& Next)
 	{
-		ShowWorksheet();
+		auto NextEvt = dynamic_cast<const FormatChangedEvent<Attr>*>(&Next);
+		if (!NextEvt || NextEvt->m_TL != m_TL || NextEvt->m_BR != m_BR || NextEvt->m_Property != m_Property)
+			return false;
 
-		for (const auto& cell : m_InitVal)
-			m_WSBase->SetCellAlignment(cell.GetRow(), cell.GetCol(), cell.GetFormat().GetHAlign(), cell.GetFormat().GetVAlign());
+		m_LastVal = NextEvt->m_LastVal;
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+		return true;
 	}
 
-	void CellAlignmentChangedEvent::Redo()
+
+	template<typename Attr>
+	auto FormatChangedEvent<Attr>::Capture() const -> std::vector<Run>
 	{
-		ShowWorksheet();
+		auto worksheet = m_WSBase.get();
 
-		for (const auto& cell : m_LastVal)
-			m_WSBase->SetCellAlignment(cell.GetRow(), cell.GetCol(), cell.GetFormat().GetHAlign(), cell.GetFormat().GetVAlign());
+		std::vector<Run> Runs;
 
-		m_WSBase->SelectBlock(m_TL, m_BR);
+		for (int i = m_TL.GetRow(); i <= m_BR.GetRow(); i++)
+		{
+			for (int j = m_TL.GetCol(); j <= m_BR.GetCol(); j++)
+			{
+				value_type Value = Attr::Get(worksheet, i, j);
+
+				if (!Runs.empty() && Runs.back().m_Value == Value)
+					Runs.back().m_Length++;
+				else
+					Runs.push_back(Run{ 1, std::move(Value) });
+			}
+		}
+
+		return Runs;
 	}
 
-	std::wstring CellAlignmentChangedEvent::GetToolTip(bool IsUndo)
+
+	template<typename Attr>
+	void FormatChangedEvent<Attr>::Apply(const std::vector<Run>& Runs)
 	{
-		std::wstringstream Tip;
-		Tip << (IsUndo ? "Undo " : "Redo ") + std::wstring(L"cell alignment");
+		auto worksheet = m_WSBase.get();
 
-		if (m_TL == m_BR)
-			Tip << "in cell " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1;
-		else
-			Tip << "in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
-			<< ColNumtoLetters(m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
+		auto CurRun = Runs.begin();
+		size_t Used = 0; //number of cells CurRun has been applied to
 
-		return Tip.str();
+		for (int i = m_TL.GetRow(); i <= m_BR.GetRow(); i++)
+		{
+			for (int j = m_TL.GetCol(); j <= m_BR.GetCol(); j++)
+			{
+				while (CurRun != Runs.end() && Used == CurRun->m_Length)
+				{
+					++CurRun;
+					Used = 0;
+				}
+
+				if (CurRun == Runs.end())
+					return;
+
+				Attr::Set(worksheet, i, j, CurRun->m_Value);
+				Used++;
+			}
+		}
 	}
 
 
+	template class DLLGRID FormatChangedEvent<BGColorAttr>;
+	template class DLLGRID FormatChangedEvent<TextColorAttr>;
+	template class DLLGRID FormatChangedEvent<FontAttr>;
+	template class DLLGRID FormatChangedEvent<AlignmentAttr>;
+
+
 
 
 	/*************   Rows Deleted Event ***************************/
 
 	void RowsDeleted::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		m_WSBase->InsertRows(m_StartPos, m_Length);
+		//throws before anything is changed if the cells cannot be read
+		auto Cells = m_InitVal.Load();
+
+		worksheet->InsertRows(m_StartPos, m_Length);
 
-		for (const auto& elem : m_InitVal) {
-			m_WSBase->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
-			m_WSBase->ApplyCellFormat(elem.GetRow(), elem.GetCol(), elem);
+		for (const auto& elem : Cells) {
+			worksheet->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
+			worksheet->ApplyCellFormat(elem.GetRow(), elem.GetCol(), elem);
 		}
 	}
 
 	void RowsDeleted::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		m_WSBase->DeleteRows(m_StartPos, m_Length);
+		worksheet->DeleteRows(m_StartPos, m_Length);
 	}
 
 	std::wstring RowsDeleted::GetToolTip(bool IsUndo)
@@ -365,6 +510,18 @@ namespace grid
 	}
 
 
+	size_t RowsDeleted::GetMemorySize() const
+	{
+		return sizeof(*this) + m_InitVal.GetMemorySize();
+	}
+
+
+	void RowsDeleted::SetInitialCells(std::vector<Cell>&& InitCells)
+	{
+		m_InitVal.Store(std::move(InitCells), m_WSBase.GetWorkbook());
+	}
+
+
 
 
 
@@ -372,16 +529,20 @@ namespace grid
 
 	void RowsInserted::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		m_WSBase->DeleteRows(m_StartPos, m_Length);
+		worksheet->DeleteRows(m_StartPos, m_Length);
 	}
 
 	void RowsInserted::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		m_WSBase->InsertRows(m_StartPos, m_Length);
+		worksheet->InsertRows(m_StartPos, m_Length);
 	}
 
 	std::wstring RowsInserted::GetToolTip(bool IsUndo)
@@ -405,20 +566,26 @@ namespace grid
 
 	void ColumnsDeleted::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
-		m_WSBase->InsertCols(m_StartPos, m_Length);
+		auto Cells = m_InitVal.Load();
 
-		for (const auto& elem : m_InitVal) {
-			m_WSBase->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
-			m_WSBase->ApplyCellFormat(elem.GetRow(), elem.GetCol(), elem);
+		worksheet->InsertCols(m_StartPos, m_Length);
+
+		for (const auto& elem : Cells) {
+			worksheet->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
+			worksheet->ApplyCellFormat(elem.GetRow(), elem.GetCol(), elem);
 		}
 
 	}
 
 	void ColumnsDeleted::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
-		m_WSBase->DeleteCols(m_StartPos, m_Length);
+		worksheet->DeleteCols(m_StartPos, m_Length);
 	}
 
 	std::wstring ColumnsDeleted::GetToolTip(bool IsUndo)
@@ -431,20 +598,36 @@ namespace grid
 	}
 
 
+	size_t ColumnsDeleted::GetMemorySize() const
+	{
+		return sizeof(*this) + m_InitVal.GetMemorySize();
+	}
+
+
+	void ColumnsDeleted::SetInitialCells(std::vector<Cell>&& InitCells)
+	{
+		m_InitVal.Store(std::move(InitCells), m_WSBase.GetWorkbook());
+	}
+
+
 
 	/*************   Columns Inserted Event ***************************/
 
 	void ColumnsInserted::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
-		m_WSBase->DeleteCols(m_StartPos, m_Length);
+		worksheet->DeleteCols(m_StartPos, m_Length);
 	}
 
 
 	void ColumnsInserted::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
-		m_WSBase->InsertCols(m_StartPos, m_Length);
+		worksheet->InsertCols(m_StartPos, m_Length);
 	}
 
 
@@ -463,18 +646,22 @@ namespace grid
 
 	void RowColSizeChanged::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		if (m_Entity == ENTITY::ROW)
-			m_WSBase->SetRowSize(m_Pos, m_PrevSize);
+			worksheet->SetRowSize(m_Pos, m_PrevSize);
 		else
-			m_WSBase->SetColSize(m_Pos, m_PrevSize);
+			worksheet->SetColSize(m_Pos, m_PrevSize);
 	}
 
 	void RowColSizeChanged::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		if (m_Entity == ENTITY::ROW)
-			m_WSBase->SetRowSize(m_Pos, m_FinalSize);
+			worksheet->SetRowSize(m_Pos, m_FinalSize);
 		else
-			m_WSBase->SetColSize(m_Pos, m_FinalSize);
+			worksheet->SetColSize(m_Pos, m_FinalSize);
 	}
 
 	std::wstring RowColSizeChanged::GetToolTip(bool IsUndo)
@@ -498,32 +685,61 @@ namespace grid
 
 	void DataPasted::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		if (m_PasteWhat == (int)CWorksheetBase::PASTE::ALL) {
-			m_WSBase->ClearBlockFormat(m_TL, m_BR);
-			m_WSBase->ClearBlockContent(m_TL, m_BR);
-		}
-		else if (m_PasteWhat == (int)CWorksheetBase::PASTE::VALUES)
-			m_WSBase->ClearBlockContent(m_TL, m_BR);
+		auto PasteWhat = (CWorksheetBase::PASTE)m_PasteWhat;
 
-		else if (m_PasteWhat == (int)CWorksheetBase::PASTE::FORMAT)
-			m_WSBase->ClearBlockFormat(m_TL, m_BR);
+		auto Cells = m_InitVal.Load();
+
+		//only populated cells are visited, cost does not depend on the area
+		worksheet->ClearPopulatedCells(m_TL, m_BR, PasteWhat);
+		worksheet->SetBlock(Cells, PasteWhat);
+
+		if (m_InferTypes)
+			worksheet->InferColTypes(m_TL.GetCol(), m_BR.GetCol());
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	void DataPasted::Redo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		auto PasteWhat = (CWorksheetBase::PASTE)m_PasteWhat;
+
+		auto Cells = m_LastVal.Load();
+
+		worksheet->ClearPopulatedCells(m_TL, m_BR, PasteWhat);
+		worksheet->SetBlock(Cells, PasteWhat);
+
+		if (m_InferTypes)
+			worksheet->InferColTypes(m_TL.GetCol(), m_BR.GetCol());
+
+		SelectBlock(m_TL, m_BR);
 	}
 
 
 	std::wstring DataPasted::GetToolTip(bool IsUndo)
 	{
 		std::wstringstream ToolTip;
+		ToolTip << (IsUndo ? L"Undo " : L"Redo ");
+
+		if (!m_Label.empty())
+			ToolTip << m_Label << " ";
 
-		if (m_PasteWhat == (int)CWorksheetBase::PASTE::ALL)
-			ToolTip << "Undo paste ";
+		else if (m_PasteWhat == (int)CWorksheetBase::PASTE::ALL)
+			ToolTip << "paste ";
 
 		else if (m_PasteWhat == (int)CWorksheetBase::PASTE::VALUES)
-			ToolTip << "Undo paste values ";
+			ToolTip << "paste values ";
 
 		else if (m_PasteWhat == (int)CWorksheetBase::PASTE::FORMAT)
-			ToolTip << "Undo paste format ";
+			ToolTip << "paste format ";
 
 		ToolTip << "in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
 			<< ColNumtoLetters(m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
@@ -532,6 +748,153 @@ namespace grid
 	}
 
 
+	size_t DataPasted::GetMemorySize() const
+	{
+		return sizeof(*this) + m_InitVal.GetMemorySize() + m_LastVal.GetMemorySize();
+	}
+
+
+	void DataPasted::SetInitialCells(std::vector<Cell>&& Cells)
+	{
+		m_InitVal.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
+
+
+	void DataPasted::SetFinalCells(std::vector<Cell>&& Cells)
+	{
+		m_LastVal.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
+
+
+
+
+
+	/*************   Data Paste Filled Event ***************************/
+
+	void DataPasteFilled::Undo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		auto PasteWhat = (CWorksheetBase::PASTE)m_PasteWhat;
+
+		auto Cells = m_InitVal.Load();
+
+		worksheet->ClearPopulatedCells(m_TL, m_BR, PasteWhat);
+		worksheet->SetBlock(Cells, PasteWhat);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	void DataPasteFilled::Redo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		worksheet->TileBlock(m_Source, m_TL, m_BR, (CWorksheetBase::PASTE)m_PasteWhat);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	std::wstring DataPasteFilled::GetToolTip(bool IsUndo)
+	{
+		std::wstringstream ToolTip;
+		ToolTip << (IsUndo ? L"Undo " : L"Redo ");
+
+		ToolTip << "paste fill in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
+			<< ColNumtoLetters(m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
+
+		return ToolTip.str();
+	}
+
+
+	size_t DataPasteFilled::GetMemorySize() const
+	{
+		return sizeof(*this) + CellsMemorySize(m_Source) + m_InitVal.GetMemorySize();
+	}
+
+
+	void DataPasteFilled::SetInitialCells(std::vector<Cell>&& Cells)
+	{
+		m_InitVal.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
+
+
+
+
+
+	/*************   Data Filled Event ***************************/
+
+	void DataFilled::Undo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		//series only write values
+		auto PasteWhat = m_Gen.IsSeries() ? CWorksheetBase::PASTE::VALUES : CWorksheetBase::PASTE::ALL;
+
+		wxGridCellCoords DestTL = m_Gen.IsDown() ?
+			wxGridCellCoords(m_TL.GetRow() + 1, m_TL.GetCol()) :
+			wxGridCellCoords(m_TL.GetRow(), m_TL.GetCol() + 1);
+
+		auto Cells = m_InitVal.Load();
+
+		worksheet->ClearPopulatedCells(DestTL, m_BR, PasteWhat);
+		worksheet->SetBlock(Cells, PasteWhat);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	void DataFilled::Redo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		worksheet->FillBlock(m_TL, m_BR, m_Gen);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	std::wstring DataFilled::GetToolTip(bool IsUndo)
+	{
+		std::wstringstream ToolTip;
+		ToolTip << (IsUndo ? L"Undo " : L"Redo ");
+
+		switch (m_Gen.m_Fill)
+		{
+		case FILL::DOWN: ToolTip << "fill down"; break;
+		case FILL::RIGHT: ToolTip << "fill right"; break;
+		case FILL::DATE: ToolTip << "date series fill"; break;
+		default: ToolTip << "series fill";
+		}
+
+		ToolTip << " in cells " << ColNumtoLetters(m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << " to "
+			<< ColNumtoLetters(m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
+
+		return ToolTip.str();
+	}
+
+
+	size_t DataFilled::GetMemorySize() const
+	{
+		return sizeof(*this) + m_InitVal.GetMemorySize();
+	}
+
+
+	void DataFilled::SetInitialCells(std::vector<Cell>&& Cells)
+	{
+		m_InitVal.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
+
+
 
 
 
@@ -539,24 +902,28 @@ namespace grid
 
 	void DataCut::Undo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		for (const auto& elem : m_Value)
+		for (const auto& elem : m_Value.Load())
 		{
-			m_WSBase->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
-			m_WSBase->ApplyCellFormat(elem.GetRow(), elem.GetCol(), elem);
+			worksheet->SetCellValue(elem.GetRow(), elem.GetCol(), elem.GetValue());
+			worksheet->ApplyCellFormat(elem.GetRow(), elem.GetCol(), elem);
 		}
 	}
 
 
 	void DataCut::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
 		ShowWorksheet();
 
-		for (const auto& elem : m_Value)
+		for (const auto& elem : m_Value.Load())
 		{
-			m_WSBase->SetCellValue(elem.GetRow(), elem.GetCol(), wxEmptyString);
-			m_WSBase->SetCellFormattoDefault(elem.GetRow(), elem.GetCol());
+			worksheet->SetCellValue(elem.GetRow(), elem.GetCol(), wxEmptyString);
+			worksheet->SetCellFormattoDefault(elem.GetRow(), elem.GetCol());
 		}
 	}
 
@@ -574,47 +941,70 @@ namespace grid
 	}
 
 
+	size_t DataCut::GetMemorySize() const
+	{
+		return sizeof(*this) + m_Value.GetMemorySize();
+	}
+
+
+	void DataCut::SetCells(std::vector<Cell>&& Cells)
+	{
+		m_Value.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
+
+
 
 	/*************   Data Moved Event ***************************/
 	
 	void DataMovedEvent::Undo()
 	{
-		m_WSBase->ClearBlockContent(m_Final_TL, m_Final_BR);
-		m_WSBase->ClearBlockFormat(m_Final_TL, m_Final_BR);
+		auto worksheet = m_WSBase.get();
+
+		auto CellValues = m_CellValues.Load();
+
+		worksheet->ClearBlockContent(m_Final_TL, m_Final_BR);
+		worksheet->ClearBlockFormat(m_Final_TL, m_Final_BR);
 
 
 		ShowWorksheet();
 
-		for (const auto& cell : m_CellValues) {
-			m_WSBase->SetCellValue(cell.GetRow(), cell.GetCol(), cell.GetValue());
-			m_WSBase->ApplyCellFormat(cell.GetRow(), cell.GetCol(), cell);
+		for (const auto& cell : CellValues) {
+			worksheet->SetCellValue(cell.GetRow(), cell.GetCol(), cell.GetValue());
+			worksheet->ApplyCellFormat(cell.GetRow(), cell.GetCol(), cell);
 		}
 	}
 
 
 	void DataMovedEvent::Redo()
 	{
+		auto worksheet = m_WSBase.get();
+
+		auto CellValues = m_CellValues.Load();
+
 		if (m_Moved) {
-			m_WSBase->ClearBlockContent(m_Init_TL, m_Init_BR);
-			m_WSBase->ClearBlockFormat(m_Init_TL, m_Init_BR);
+			worksheet->ClearBlockContent(m_Init_TL, m_Init_BR);
+			worksheet->ClearBlockFormat(m_Init_TL, m_Init_BR);
 		}
 
 
 		ShowWorksheet();
 
-		auto InitialCoords = Cell::Get_TLBR(m_CellValues);
+		if (CellValues.empty())
+			return;
+
+		auto InitialCoords = Cell::Get_TLBR(CellValues);
 
 		int diffRow = InitialCoords.first.GetRow() - m_Final_TL.GetRow();
 		int diffCol = InitialCoords.first.GetCol() - m_Final_TL.GetCol();
 
 
-		for (const auto& elem : m_CellValues) {
+		for (const auto& elem : CellValues) {
 			//final=initial-diff
 			int row = elem.GetRow() - diffRow;
 			int col = elem.GetCol() - diffCol;
 
-			m_WSBase->SetCellValue(row, col, elem.GetValue());
-			m_WSBase->ApplyCellFormat(row, col, elem);
+			worksheet->SetCellValue(row, col, elem.GetValue());
+			worksheet->ApplyCellFormat(row, col, elem);
 		}
 
 
@@ -637,4 +1027,320 @@ namespace grid
 	}
 
 
-}
\ No newline at end of file
+	size_t DataMovedEvent::GetMemorySize() const
+	{
+		return sizeof(*this) + m_CellValues.GetMemorySize();
+	}
+
+
+	void DataMovedEvent::SetCells(std::vector<Cell>&& Cells)
+	{
+		m_CellValues.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
+
+
+
+	/*************   Rows Sorted Event ***************************/
+
+	void RowsSortedEvent::Undo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		std::vector<int> Inverse(m_Perm.size());
+		for (size_t i = 0; i < m_Perm.size(); ++i)
+			Inverse[m_Perm[i]] = (int)i;
+
+		worksheet->PermuteRows(m_TL, m_BR, Inverse);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	void RowsSortedEvent::Redo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		worksheet->PermuteRows(m_TL, m_BR, m_Perm);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	std::wstring RowsSortedEvent::GetToolTip(bool IsUndo)
+	{
+		std::wstringstream ToolTip;
+		ToolTip << (IsUndo ? L"Undo " : L"Redo ");
+
+		ToolTip << "sort " << ColNumtoLetters((size_t)m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << ":"
+			<< ColNumtoLetters((size_t)m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
+
+		return ToolTip.str();
+	}
+
+
+	size_t RowsSortedEvent::GetMemorySize() const
+	{
+		return sizeof(*this) + m_Perm.capacity() * sizeof(int);
+	}
+
+
+
+
+	/*************   Duplicates Removed Event ***************************/
+
+	void DuplicatesRemovedEvent::Undo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		auto Perm = GetPermutation();
+
+		std::vector<int> Inverse(Perm.size());
+		for (size_t i = 0; i < Perm.size(); ++i)
+			Inverse[Perm[i]] = (int)i;
+
+		worksheet->SetBlock(m_Cells.Load());
+		worksheet->PermuteRows(m_TL, m_BR, Inverse);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	void DuplicatesRemovedEvent::Redo()
+	{
+		auto worksheet = m_WSBase.get();
+
+		ShowWorksheet();
+
+		worksheet->PermuteRows(m_TL, m_BR, GetPermutation());
+
+		wxGridCellCoords BottomTL(m_BR.GetRow() - (int)m_Removed.size() + 1, m_TL.GetCol());
+		worksheet->ClearPopulatedCells(BottomTL, m_BR);
+
+		SelectBlock(m_TL, m_BR);
+	}
+
+
+	std::wstring DuplicatesRemovedEvent::GetToolTip(bool IsUndo)
+	{
+		std::wstringstream ToolTip;
+		ToolTip << (IsUndo ? L"Undo " : L"Redo ");
+
+		ToolTip << "remove " << m_Removed.size() << " duplicate rows from "
+			<< ColNumtoLetters((size_t)m_TL.GetCol() + 1) << m_TL.GetRow() + 1 << ":"
+			<< ColNumtoLetters((size_t)m_BR.GetCol() + 1) << m_BR.GetRow() + 1;
+
+		return ToolTip.str();
+	}
+
+
+	size_t DuplicatesRemovedEvent::GetMemorySize() const
+	{
+		return sizeof(*this) + m_Removed.capacity() * sizeof(int) + m_Cells.GetMemorySize();
+	}
+
+
+	void DuplicatesRemovedEvent::SetRemovedCells(std::vector<Cell>&& Cells)
+	{
+		m_Cells.Store(std::move(Cells), m_WSBase.GetWorkbook());
+	}
+
+
+	std::vector<int> DuplicatesRemovedEvent::GetPermutation() const
+	{
+		int NRows = m_BR.GetRow() - m_TL.GetRow() + 1;
+
+		std::vector<int> Perm;
+		Perm.reserve(NRows);
+
+		//kept rows in their order, then the removed ones
+		size_t k = 0;
+		for (int i = 0; i < NRows; ++i)
+		{
+			if (k < m_Removed.size() && m_Removed[k] == i)
+				++k;
+			else
+				Perm.push_back(i);
+		}
+
+		Perm.insert(Perm.end(), m_Removed.begin(), m_Removed.end());
+
+		return Perm;
+	}
+
+
+
+	/*************   Transaction Event ***************************/
+
+	//consecutive cell value changes on a worksheet while a transaction is open
+	class CellValuesJournal : public WSUndoRedoEvent
+	{
+		struct Entry
+		{
+			int m_Row, m_Col;
+			std::wstring m_OldValue, m_NewValue;
+		};
+
+	public:
+		CellValuesJournal(CWorksheetBase* worksheet) :
+		WSUndoRedoEvent(worksheet, true) {}
+
+		void Undo() override
+		{
+			auto worksheet = m_WSBase.get();
+
+			for (auto it = m_Entries.rbegin(); it != m_Entries.rend(); ++it)
+				worksheet->SetValue(it->m_Row, it->m_Col, it->m_OldValue, false);
+
+			worksheet->MarkDirty();
+		}
+
+		void Redo() override
+		{
+			auto worksheet = m_WSBase.get();
+
+			for (const auto& entry : m_Entries)
+				worksheet->SetValue(entry.m_Row, entry.m_Col, entry.m_NewValue, false);
+
+			worksheet->MarkDirty();
+		}
+
+		std::wstring GetToolTip(bool IsUndo) override {
+			return IsUndo ? L"Undo cell changes" : L"Redo cell changes";
+		}
+
+		size_t GetMemorySize() const override
+		{
+			size_t Size = sizeof(*this) + m_Entries.capacity() * sizeof(Entry);
+			for (const auto& entry : m_Entries)
+				Size += (entry.m_OldValue.capacity() + entry.m_NewValue.capacity()) * sizeof(wchar_t);
+
+			return Size;
+		}
+
+		void Add(int row, int col, std::wstring&& OldValue, std::wstring&& NewValue) {
+			m_Entries.emplace_back(row, col, std::move(OldValue), std::move(NewValue));
+		}
+
+	private:
+		std::vector<Entry> m_Entries;
+	};
+
+
+
+	void TransactionEvent::Undo()
+	{
+		CNotificationsSuspended Suspended(m_Workbook);
+
+		//events are undone from the last, i.e. [N - NUndone, N) have been undone
+		size_t N = m_Events.size(), NUndone = 0;
+
+		try
+		{
+			//events of removed worksheets are skipped
+			for (; NUndone < N; ++NUndone)
+			{
+				auto& evt = m_Events[N - 1 - NUndone];
+				if (evt->GetEventSource())
+					evt->Undo();
+			}
+		}
+		catch (...)
+		{
+			//the failed event has not changed anything (cells are loaded first), the others are redone
+			for (size_t i = N - NUndone; i < N; ++i)
+			{
+				if (m_Events[i]->GetEventSource())
+					m_Events[i]->Redo();
+			}
+
+			throw;
+		}
+
+		ShowWorksheet();
+	}
+
+
+	void TransactionEvent::Redo()
+	{
+		CNotificationsSuspended Suspended(m_Workbook);
+
+		size_t NRedone = 0;
+
+		try
+		{
+			for (; NRedone < m_Events.size(); ++NRedone)
+			{
+				auto& evt = m_Events[NRedone];
+				if (evt->GetEventSource())
+					evt->Redo();
+			}
+		}
+		catch (...)
+		{
+			for (size_t i = NRedone; i-- > 0;)
+			{
+				if (m_Events[i]->GetEventSource())
+					m_Events[i]->Undo();
+			}
+
+			throw;
+		}
+
+		ShowWorksheet();
+	}
+
+
+	std::wstring TransactionEvent::GetToolTip(bool IsUndo)
+	{
+		std::wstringstream ToolTip;
+		ToolTip << (IsUndo ? L"Undo " : L"Redo ");
+		ToolTip << (m_Label.empty() ? L"changes" : m_Label);
+
+		return ToolTip.str();
+	}
+
+
+	size_t TransactionEvent::GetMemorySize() const
+	{
+		size_t Size = sizeof(*this) + m_Events.capacity() * sizeof(m_Events[0]);
+		for (const auto& evt : m_Events)
+			Size += evt->GetMemorySize();
+
+		return Size;
+	}
+
+
+	void TransactionEvent::Add(std::unique_ptr<WSUndoRedoEvent> event)
+	{
+		//a single event that cannot be redone makes the whole transaction so
+		m_CanRedo = m_CanRedo && event->CanRedo();
+		m_Events.push_back(std::move(event));
+	}
+
+
+	void TransactionEvent::AddValueChange(
+		CWorksheetBase* worksheet,
+		int row,
+		int col,
+		std::wstring&& OldValue,
+		std::wstring&& NewValue)
+	{
+		auto Journal = m_Events.empty() ? nullptr : dynamic_cast<CellValuesJournal*>(m_Events.back().get());
+
+		if (!Journal || Journal->GetEventSourceId() != worksheet->GetWSId())
+		{
+			auto NewJournal = std::make_unique<CellValuesJournal>(worksheet);
+			Journal = NewJournal.get();
+			m_Events.push_back(std::move(NewJournal));
+		}
+
+		Journal->Add(row, col, std::move(OldValue), std::move(NewValue));
+	}
+
+}
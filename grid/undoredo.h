@@ -2,10 +2,15 @@
 
 #include <string>
 #include <vector>
+#include <utility>
+#include <memory>
+#include <chrono>
 
 #include <wx/wx.h>
 
 #include "ws_cell.h"
+#include "cellstore.h"
+#include "fill.h"
 
 #include "dllimpexp.h"
 
@@ -14,21 +19,61 @@
 namespace grid
 {
 	class CWorksheetBase;
+	class CWorkbookBase;
+
+
+	/*
+		Refers to a worksheet by its id, the pointer is looked up from the workbook when used.
+		If the worksheet has been removed, get() returns nullptr.
+		get() searches the workbook's worksheets, therefore events call it once per Undo/Redo.
+	*/
+	class DLLGRID WorksheetRef
+	{
+	public:
+		WorksheetRef(CWorksheetBase* worksheet);
+
+		CWorksheetBase* get() const;
+
+		CWorksheetBase* operator->() const {
+			return get();
+		}
+
+		size_t GetId() const {
+			return m_Id;
+		}
+
+		CWorkbookBase* GetWorkbook() const {
+			return m_Workbook;
+		}
+
+	private:
+		CWorkbookBase* m_Workbook{ nullptr };
+		size_t m_Id{ 0 };
+
+		//only used if worksheet is not owned by a workbook
+		CWorksheetBase* m_Worksheet{ nullptr };
+	};
+
+
 
 	class DLLGRID WSUndoRedoEvent
 	{
 	public:
-		WSUndoRedoEvent(CWorksheetBase* worksheet, bool CanRedo)
+		WSUndoRedoEvent(CWorksheetBase* worksheet, bool CanRedo): m_WSBase{ worksheet }
 		{
 			m_CanRedo = CanRedo;
-			m_WSBase = worksheet;
 		}
 		virtual ~WSUndoRedoEvent() = default;
 
 		void ShowWorksheet(); //Show the worksheet where events are happening
 
-		auto GetEventSource() const {
-			return m_WSBase;
+		//nullptr if the worksheet has been removed
+		CWorksheetBase* GetEventSource() const {
+			return m_WSBase.get();
+		}
+
+		size_t GetEventSourceId() const {
+			return m_WSBase.GetId();
 		}
 
 		bool CanRedo() const {
@@ -39,9 +84,40 @@ namespace grid
 		virtual void Undo() = 0;
 		virtual void Redo() = 0;
 
+		//approximate number of bytes the event holds (used for the memory budget of undo history)
+		virtual size_t GetMemorySize() const {
+			return sizeof(*this);
+		}
+
+		//when the event was created or last merged
+		auto GetTimeStamp() const {
+			return m_TimeStamp;
+		}
+
+		/*
+			Absorbs Next if it is a continuation of this event on the same worksheet,
+			keeping this event's before-image and Next's after-image.
+			Returns false if they cannot be merged.
+		*/
+		bool MergeWith(const WSUndoRedoEvent& Next);
+
+	protected:
+		virtual bool Merge(const WSUndoRedoEvent& Next) {
+			return false;
+		}
+
+		//while the workbook replays several events, only the union of the blocks is selected at the end
+		void SelectBlock(const wxGridCellCoords& TL, const wxGridCellCoords& BR);
+
+		//clears the selection and moves the cursor to the cell
+		void GoToCell(int row, int col);
+
 	protected:
-		CWorksheetBase* m_WSBase;
+		WorksheetRef m_WSBase;
 		bool m_CanRedo;
+
+	private:
+		std::chrono::steady_clock::time_point m_TimeStamp{ std::chrono::steady_clock::now() };
 	};
 
 
@@ -63,10 +139,15 @@ namespace grid
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
 		std::wstring m_InitVal; //Before the change
 		std::wstring m_LastVal; //After the change
 
+	protected:
+		//successive edits of the same cell
+		bool Merge(const WSUndoRedoEvent& Next) override;
+
 	private:
 		int m_row, m_col;
 	};
@@ -88,6 +169,7 @@ namespace grid
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
 		std::wstring m_InitVal; //Before the change
 		std::wstring m_LastVal; //After the change
@@ -108,10 +190,9 @@ namespace grid
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
-		void SetInitialCells(const std::vector<Cell>& Cells){
-			m_InitVal = Cells;
-		}
+		void SetInitialCells(std::vector<Cell>&& Cells);
 
 		void SetCoords(const wxGridCellCoords& TL, const wxGridCellCoords& BR) {
 			m_TL = TL;
@@ -119,80 +200,129 @@ namespace grid
 		}
 
 	private:
-		std::vector<Cell> m_InitVal; //Before the change
+		CellStore m_InitVal; //Before the change
 		wxGridCellCoords m_TL, m_BR;
 	};
 
 
 
-	struct DLLGRID CellBGColorChangedEvent : WSUndoRedoEvent
+	/*
+		Format attributes that are changed on a block of cells.
+		Get/Set work on a single cell, Name is used by tooltips.
+	*/
+	struct DLLGRID BGColorAttr
 	{
-		CellBGColorChangedEvent(CWorksheetBase* worksheet):
-		WSUndoRedoEvent(worksheet, true) {}
+		using value_type = wxColour;
 
-		void Undo() override;
-		void Redo() override;
+		static value_type Get(const CWorksheetBase* ws, int row, int col);
+		static void Set(CWorksheetBase* ws, int row, int col, const value_type& Value);
+		static std::wstring Name(const std::string& Property);
+	};
 
-		std::wstring GetToolTip(bool IsUndo) override;
 
-		std::vector<Cell> m_InitVal; //Before the change
-		std::vector<Cell> m_LastVal; //After the change
+	struct DLLGRID TextColorAttr
+	{
+		using value_type = wxColour;
 
-		wxGridCellCoords m_TL, m_BR;
+		static value_type Get(const CWorksheetBase* ws, int row, int col);
+		static void Set(CWorksheetBase* ws, int row, int col, const value_type& Value);
+		static std::wstring Name(const std::string& Property);
 	};
 
 
-
-	struct DLLGRID TextColorChangedEvent : WSUndoRedoEvent
+	struct DLLGRID FontAttr
 	{
-		TextColorChangedEvent(CWorksheetBase* worksheet):
-		WSUndoRedoEvent(worksheet, true) {}
+		using value_type = wxFont;
 
-		void Undo() override;
-		void Redo() override;
+		static value_type Get(const CWorksheetBase* ws, int row, int col);
+		static void Set(CWorksheetBase* ws, int row, int col, const value_type& Value);
+		static std::wstring Name(const std::string& Property);
+	};
 
-		std::wstring GetToolTip(bool IsUndo) override;
 
-		std::vector<Cell> m_InitVal; //Before the change
-		std::vector<Cell> m_LastVal; //After the change
+	struct DLLGRID AlignmentAttr
+	{
+		using value_type = std::pair<int, int>; //horizontal, vertical
 
-		wxGridCellCoords m_TL, m_BR;
+		static value_type Get(const CWorksheetBase* ws, int row, int col);
+		static void Set(CWorksheetBase* ws, int row, int col, const value_type& Value);
+		static std::wstring Name(const std::string& Property);
 	};
 
 
 
-	struct DLLGRID FontChangedEvent : WSUndoRedoEvent
+	/*
+		Only the changed attribute is stored, run-length encoded over the rectangle (row-major).
+		Changing a large block to a single color therefore costs a few runs instead of full Cell snapshots.
+	*/
+	template<typename Attr>
+	class FormatChangedEvent : public WSUndoRedoEvent
 	{
-		FontChangedEvent(CWorksheetBase* worksheet):
-		WSUndoRedoEvent(worksheet, true) {}
+	public:
+		using value_type = typename Attr::value_type;
+
+		//consecutive cells sharing the same value
+		struct Run
+		{
+			size_t m_Length;
+			value_type m_Value;
+		};
+
+	public:
+		FormatChangedEvent(
+			CWorksheetBase* worksheet, 
+			const wxGridCellCoords& TL, 
+			const wxGridCellCoords& BR) :
+		WSUndoRedoEvent(worksheet, true)
+		{
+			m_TL = TL;
+			m_BR = BR;
+		}
 
 		void Undo() override;
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
-		std::vector<Cell> m_InitVal, m_LastVal;
-		std::string m_FontProperty; //Info on changed property, such as "Size", "Face", "Bold" ...
-		wxGridCellCoords m_TL, m_BR;
-	};
-
+		//must be called before the block is changed
+		void SetInitial() {
+			m_InitVal = Capture();
+		}
 
+		//must be called after the block is changed
+		void SetFinal() {
+			m_LastVal = Capture();
+		}
 
-	struct DLLGRID CellAlignmentChangedEvent : WSUndoRedoEvent
-	{
-		CellAlignmentChangedEvent(CWorksheetBase* worksheet):
-		WSUndoRedoEvent(worksheet, true) {}
+		std::string m_Property; //Info on changed property, such as "size", "face", "bold" ...
 
-		void Undo() override;
-		void Redo() override;
+	protected:
+		//successive changes of the same property on the same block
+		bool Merge(const WSUndoRedoEvent& Next) override;
 
-		std::wstring GetToolTip(bool IsUndo) override;
+	private:
+		std::vector<Run> Capture() const;
+		void Apply(const std::vector<Run>& Runs);
 
-		std::vector<Cell> m_InitVal, m_LastVal;
+	private:
+		std::vector<Run> m_InitVal, m_LastVal;
 		wxGridCellCoords m_TL, m_BR;
 	};
 
 
+	//instantiated in undoredo.cpp
+	extern template class DLLGRID FormatChangedEvent<BGColorAttr>;
+	extern template class DLLGRID FormatChangedEvent<TextColorAttr>;
+	extern template class DLLGRID FormatChangedEvent<FontAttr>;
+	extern template class DLLGRID FormatChangedEvent<AlignmentAttr>;
+
+	using CellBGColorChangedEvent = FormatChangedEvent<BGColorAttr>;
+	using TextColorChangedEvent = FormatChangedEvent<TextColorAttr>;
+	using FontChangedEvent = FormatChangedEvent<FontAttr>;
+	using CellAlignmentChangedEvent = FormatChangedEvent<AlignmentAttr>;
+
+
 
 	class DLLGRID RowsDeleted : public WSUndoRedoEvent
 	{
@@ -204,6 +334,7 @@ namespace grid
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
 		void SetInfo(int Start, int Length) 
 		{
@@ -211,12 +342,10 @@ namespace grid
 			m_Length = Length;
 		}
 
-		void SetInitialCells(const std::vector<Cell>& InitCells){
-			m_InitVal = InitCells;
-		}
+		void SetInitialCells(std::vector<Cell>&& InitCells);
 
 	private:
-		std::vector<Cell> m_InitVal; //Before the change
+		CellStore m_InitVal; //Before the change
 		int m_StartPos, m_Length;
 	};
 
@@ -257,6 +386,7 @@ namespace grid
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
 		void SetInfo(int Start, int Length)
 		{
@@ -264,13 +394,11 @@ namespace grid
 			m_Length = Length;
 		}
 
-		void SetInitialCells(const std::vector<Cell>& InitCells){
-			m_InitVal = InitCells;
-		}
+		void SetInitialCells(std::vector<Cell>&& InitCells);
 
 	private:
 
-		std::vector<Cell> m_InitVal; //Before the change
+		CellStore m_InitVal; //Before the change
 		int m_StartPos, m_Length;
 	};
 
@@ -331,12 +459,13 @@ namespace grid
 	{
 	public:
 		DataPasted(CWorksheetBase* worksheet):
-		WSUndoRedoEvent(worksheet, false) {} //Cannot redo
+		WSUndoRedoEvent(worksheet, true) {}
 
 		void Undo() override; 
-		void Redo() override{}
+		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
 		void SetCoords(const wxGridCellCoords& TL, const wxGridCellCoords& BR) 
 		{
@@ -355,9 +484,96 @@ namespace grid
 			m_PasteWhat = pastewhat;
 		}
 
+		//shown instead of "paste" for operations writing a block the same way (i.e., join)
+		void SetLabel(const std::wstring& Label) {
+			m_Label = Label;
+		}
+
+		//only the populated cells of the pasted area (see CWorksheetBase::GetPopulatedCells)
+		void SetInitialCells(std::vector<Cell>&& Cells);
+		void SetFinalCells(std::vector<Cell>&& Cells);
+
+		//text was pasted, the types of the pasted columns are inferred again after undo and redo
+		void SetInferTypes(bool InferTypes) {
+			m_InferTypes = InferTypes;
+		}
+
 	private:
 		int m_PasteWhat;
 		wxGridCellCoords m_TL, m_BR;
+		std::wstring m_Label;
+		bool m_InferTypes{ false };
+
+		CellStore m_InitVal, m_LastVal; //before and after the paste
+	};
+
+
+
+	//clipboard block tiled over a rectangle
+	class DLLGRID DataPasteFilled : public WSUndoRedoEvent
+	{
+	public:
+		DataPasteFilled(CWorksheetBase* worksheet):
+		WSUndoRedoEvent(worksheet, true) {}
+
+		void Undo() override; 
+		void Redo() override;
+
+		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
+
+		//rectangle that is tiled
+		void SetCoords(const wxGridCellCoords& TL, const wxGridCellCoords& BR) 
+		{
+			m_TL = TL;
+			m_BR = BR;
+		}
+
+		void SetSource(std::vector<Cell>&& Cells) {
+			m_Source = std::move(Cells);
+		}
+
+		//populated cells of the rectangle before they are overwritten
+		void SetInitialCells(std::vector<Cell>&& Cells);
+
+		void SetPaste(int pastewhat) {
+			m_PasteWhat = pastewhat;
+		}
+
+	private:
+		int m_PasteWhat;
+
+		//only the block on the clipboard, the filled cells are generated from it
+		std::vector<Cell> m_Source;
+		CellStore m_InitVal;
+		wxGridCellCoords m_TL, m_BR;
+	};
+
+
+
+	//rectangle filled from its first row or column, only the generator is kept to redo
+	class DLLGRID DataFilled : public WSUndoRedoEvent
+	{
+	public:
+		DataFilled(
+			CWorksheetBase* worksheet,
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			const FillGenerator& Gen) : WSUndoRedoEvent(worksheet, true), m_TL{ TL }, m_BR{ BR }, m_Gen{ Gen } {}
+
+		void Undo() override;
+		void Redo() override;
+
+		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
+
+		//populated cells of the filled area before they are overwritten
+		void SetInitialCells(std::vector<Cell>&& Cells);
+
+	private:
+		wxGridCellCoords m_TL, m_BR;
+		FillGenerator m_Gen;
+		CellStore m_InitVal;
 	};
 
 
@@ -372,10 +588,9 @@ namespace grid
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
-		void SetCells(const std::vector<Cell>& Cells){
-			m_Value = Cells;
-		}
+		void SetCells(std::vector<Cell>&& Cells);
 
 		void SetCoords(const wxGridCellCoords& TL, const wxGridCellCoords& BR) 
 		{
@@ -385,7 +600,7 @@ namespace grid
 
 	private:
 
-		std::vector<Cell>	m_Value;
+		CellStore m_Value;
 		wxGridCellCoords m_TL, m_BR;
 	};
 
@@ -404,6 +619,7 @@ namespace grid
 		void Redo() override;
 
 		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
 
 		void SetInitCoords(const wxGridCellCoords& TL, const wxGridCellCoords& BR) 
 		{
@@ -417,13 +633,11 @@ namespace grid
 			m_Final_BR = BR;
 		}
 
-		void SetCells(const std::vector<Cell>& Cells){
-			m_CellValues = Cells;
-		}
+		void SetCells(std::vector<Cell>&& Cells);
 
 	private:
 
-		std::vector<Cell>	m_CellValues; //Initial location and values
+		CellStore m_CellValues; //Initial location and values
 
 		wxGridCellCoords m_Init_TL, m_Init_BR;
 		wxGridCellCoords m_Final_TL, m_Final_BR;
@@ -434,4 +648,108 @@ namespace grid
 	};
 
 
+
+	//rows of a block sorted, only the permutation is stored
+	class DLLGRID RowsSortedEvent : public WSUndoRedoEvent
+	{
+	public:
+		RowsSortedEvent(
+			CWorksheetBase* worksheet,
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			std::vector<int>&& Perm) : WSUndoRedoEvent(worksheet, true), m_TL{ TL }, m_BR{ BR }, m_Perm{ std::move(Perm) } {}
+
+		void Undo() override;
+		void Redo() override;
+
+		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
+
+	private:
+		wxGridCellCoords m_TL, m_BR;
+
+		//row TL + i received row TL + m_Perm[i]
+		std::vector<int> m_Perm;
+	};
+
+
+
+	/*
+		Duplicate rows moved to the bottom of the block and cleared.
+		Stores the indices of the removed rows and their cells, the order of the others follows from them.
+	*/
+	class DLLGRID DuplicatesRemovedEvent : public WSUndoRedoEvent
+	{
+	public:
+		DuplicatesRemovedEvent(
+			CWorksheetBase* worksheet,
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			std::vector<int>&& Removed) : WSUndoRedoEvent(worksheet, true), m_TL{ TL }, m_BR{ BR }, m_Removed{ std::move(Removed) } {}
+
+		void Undo() override;
+		void Redo() override;
+
+		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
+
+		//populated cells of the removed rows after they were moved to the bottom
+		void SetRemovedCells(std::vector<Cell>&& Cells);
+
+	private:
+		//row TL + i of the compacted block received row TL + Perm[i]
+		std::vector<int> GetPermutation() const;
+
+	private:
+		wxGridCellCoords m_TL, m_BR;
+
+		std::vector<int> m_Removed; //relative to TL, ascending
+		CellStore m_Cells;
+	};
+
+
+
+	/*
+		Edits made while a CTransaction is open.
+		Undone and redone as a single step: if an inner event throws, 
+		the events already applied are reverted before the exception is rethrown.
+	*/
+	class DLLGRID TransactionEvent : public WSUndoRedoEvent
+	{
+	public:
+		//worksheet can be null (i.e. no active worksheet)
+		TransactionEvent(
+			CWorkbookBase* workbook, 
+			CWorksheetBase* worksheet, 
+			const std::wstring& Label = L"") :
+		WSUndoRedoEvent(worksheet, true), m_Workbook{ workbook }, m_Label{ Label } {}
+
+		void Undo() override;
+		void Redo() override;
+
+		std::wstring GetToolTip(bool IsUndo) override;
+		size_t GetMemorySize() const override;
+
+		//events pushed while the transaction is open
+		void Add(std::unique_ptr<WSUndoRedoEvent> event);
+
+		//cell value written through SetCellValue or SetValue
+		void AddValueChange(
+			CWorksheetBase* worksheet,
+			int row,
+			int col,
+			std::wstring&& OldValue,
+			std::wstring&& NewValue);
+
+		bool empty() const {
+			return m_Events.empty();
+		}
+
+	private:
+		CWorkbookBase* m_Workbook{ nullptr };
+		std::vector<std::unique_ptr<WSUndoRedoEvent>> m_Events; //in the order they happened
+		std::wstring m_Label;
+	};
+
+
 }
@@ -0,0 +1,154 @@
+#include "valueindex.h"
+
+#include <algorithm>
+
+
+
+namespace grid
+{
+	//trimming allocates, only trim if necessary
+	static wxString Key(const wxString& Value)
+	{
+		if (!Value.empty() && (wxIsspace(Value[0]) || wxIsspace(Value.Last())))
+			return wxString(Value).Trim().Trim(false);
+
+		return Value;
+	}
+
+
+
+	void CValueIndex::Add(const wxString& Value, const wxGridCellCoords& Coord)
+	{
+		wxString key = Key(Value);
+		if (key.empty())
+			return;
+
+		if (m_Map[key].insert(Coord).second)
+			m_NCells++;
+	}
+
+
+	void CValueIndex::Remove(const wxString& Value, const wxGridCellCoords& Coord)
+	{
+		auto it = m_Map.find(Key(Value));
+		if (it == m_Map.end())
+			return;
+
+		if (it->second.erase(Coord) > 0)
+			m_NCells--;
+
+		if (it->second.empty())
+			m_Map.erase(it);
+	}
+
+
+	std::vector<wxGridCellCoords> CValueIndex::Find(
+		const wxString& Value,
+		bool Prefix,
+		const wxGridCellCoords& TL,
+		const wxGridCellCoords& BR) const
+	{
+		std::vector<wxGridCellCoords> Result;
+
+		wxString key = Key(Value);
+		if (key.empty())
+			return Result;
+
+		if (!Prefix)
+		{
+			if (auto it = m_Map.find(key); it != m_Map.end())
+				Collect(it->second, TL, BR, Result);
+
+			return Result;
+		}
+
+		//keys starting with the prefix are adjacent in the map
+		for (auto it = m_Map.lower_bound(key); it != m_Map.end() && it->first.StartsWith(key); ++it)
+			Collect(it->second, TL, BR, Result);
+
+		std::sort(Result.begin(), Result.end(), CoordComp());
+
+		return Result;
+	}
+
+
+	void CValueIndex::Collect(
+		const CoordSet& Cells,
+		const wxGridCellCoords& TL,
+		const wxGridCellCoords& BR,
+		std::vector<wxGridCellCoords>& Result)
+	{
+		if (TL == wxGridNoCellCoords || BR == wxGridNoCellCoords)
+		{
+			Result.insert(Result.end(), Cells.begin(), Cells.end());
+			return;
+		}
+
+		for (auto it = Cells.lower_bound(TL); it != Cells.end() && it->GetRow() <= BR.GetRow(); ++it)
+		{
+			if (it->GetCol() >= TL.GetCol() && it->GetCol() <= BR.GetCol())
+				Result.push_back(*it);
+		}
+	}
+
+
+	template<typename Func>
+	void CValueIndex::Shift(Func&& MoveCoord)
+	{
+		m_NCells = 0;
+
+		for (auto it = m_Map.begin(); it != m_Map.end();)
+		{
+			//the mapping keeps the order of the remaining cells, the set is rebuilt in linear time
+			CoordSet Cells;
+			for (const auto& Coord : it->second)
+			{
+				auto NewCoord = MoveCoord(Coord);
+				if (NewCoord != wxGridNoCellCoords)
+					Cells.insert(Cells.end(), NewCoord);
+			}
+
+			m_NCells += Cells.size();
+
+			if (Cells.empty())
+				it = m_Map.erase(it);
+			else
+			{
+				it->second = std::move(Cells);
+				++it;
+			}
+		}
+	}
+
+
+	void CValueIndex::ShiftRows(int Pos, int Num)
+	{
+		Shift([Pos, Num](const wxGridCellCoords& Coord)
+		{
+			int Row = Coord.GetRow();
+			if (Row < Pos)
+				return Coord;
+
+			if (Num < 0 && Row < Pos - Num)
+				return wxGridNoCellCoords;
+
+			return wxGridCellCoords(Row + Num, Coord.GetCol());
+		});
+	}
+
+
+	void CValueIndex::ShiftCols(int Pos, int Num)
+	{
+		Shift([Pos, Num](const wxGridCellCoords& Coord)
+		{
+			int Col = Coord.GetCol();
+			if (Col < Pos)
+				return Coord;
+
+			if (Num < 0 && Col < Pos - Num)
+				return wxGridNoCellCoords;
+
+			return wxGridCellCoords(Coord.GetRow(), Col + Num);
+		});
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <wx/wx.h>
+#include <wx/grid.h>
+
+#include "dllimpexp.h"
+
+
+namespace grid
+{
+	/*
+		Maps cell values to the coordinates of the cells holding them.
+		Values are trimmed before they are used as keys (as CRangeBase compares them), empty cells are not indexed.
+	*/
+	class DLLGRID CValueIndex
+	{
+		struct CoordComp
+		{
+			bool operator() (const wxGridCellCoords& p1, const wxGridCellCoords& p2) const
+			{
+				return p1.GetRow() < p2.GetRow() ||
+					(p1.GetRow() == p2.GetRow() && p1.GetCol() < p2.GetCol());
+			}
+		};
+
+		using CoordSet = std::set<wxGridCellCoords, CoordComp>;
+
+	public:
+		CValueIndex() = default;
+
+		void Add(const wxString& Value, const wxGridCellCoords& Coord);
+		void Remove(const wxString& Value, const wxGridCellCoords& Coord);
+
+		void Update(const wxGridCellCoords& Coord, const wxString& OldValue, const wxString& NewValue)
+		{
+			Remove(OldValue, Coord);
+			Add(NewValue, Coord);
+		}
+
+		/*
+			Cells whose value equals Value (or starts with Value if Prefix), ordered by row then column.
+			Only cells within TL and BR are returned if both are valid.
+		*/
+		std::vector<wxGridCellCoords> Find(
+			const wxString& Value,
+			bool Prefix = false,
+			const wxGridCellCoords& TL = wxGridNoCellCoords,
+			const wxGridCellCoords& BR = wxGridNoCellCoords) const;
+
+		//rows at and after Pos move down by Num, if Num is negative rows [Pos, Pos - Num) are removed
+		void ShiftRows(int Pos, int Num);
+		void ShiftCols(int Pos, int Num);
+
+		//number of indexed cells
+		size_t size() const {
+			return m_NCells;
+		}
+
+		void clear()
+		{
+			m_Map.clear();
+			m_NCells = 0;
+		}
+
+	private:
+		//appends the cells of the bucket that are in the block
+		static void Collect(
+			const CoordSet& Cells,
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			std::vector<wxGridCellCoords>& Result);
+
+		//MoveCoord returns the new coordinates of a cell or wxGridNoCellCoords if the cell is removed
+		template<typename Func>
+		void Shift(Func&& MoveCoord);
+
+	private:
+		std::map<wxString, CoordSet> m_Map;
+		size_t m_NCells{ 0 };
+	};
+}
@@ -1,5 +1,6 @@
 #include "workbookbase.h"
 
+#include <algorithm>
 #include <codecvt>
 #include <locale>
 #include <wx/sstream.h>
@@ -10,6 +11,7 @@
 #include "undoredo.h"
 #include "ws_cell.h"
 #include "ws_funcs.h"
+#include "findreplace.h"
 
 #include "events.h"
 
@@ -19,7 +21,11 @@ namespace grid
 	{
 	}
 
-	CWorkbookBase::~CWorkbookBase() = default;
+	CWorkbookBase::~CWorkbookBase()
+	{
+		//copied cells stay on the clipboard after the application exits, XML is only rendered now
+		wxTheClipboard->Flush();
+	}
 
 	CWorksheetBase* CWorkbookBase::GetActiveWS() const {
 		return m_WSNtbk->GetActiveWorksheet();
@@ -33,6 +39,18 @@ namespace grid
 		return m_WSNtbk->FindWorksheet(PageNumber);
 	}
 
+	CWorksheetBase* CWorkbookBase::GetWorksheetById(size_t Id) const 
+	{
+		for (size_t i = 0; i < m_WSNtbk->GetPageCount(); i++)
+		{
+			auto ws = m_WSNtbk->FindWorksheet(i);
+			if (ws && ws->GetWSId() == Id)
+				return ws;
+		}
+
+		return nullptr;
+	}
+
 	size_t CWorkbookBase::size() const {
 		return m_WSNtbk->GetPageCount();
 	}
@@ -63,18 +81,38 @@ namespace grid
 
 	void CWorkbookBase::PushUndoEvent(std::unique_ptr<WSUndoRedoEvent> event)
 	{
-		//Check if current event and event on the top of redo stack are the same
-		if (!m_UndoStack.empty())
+		//becomes part of the transaction's event
+		if (m_Transaction && event.get() != m_Transaction.get())
 		{
-			auto top = m_UndoStack.top().get();
-			if (!(top == event.get()))
-				m_UndoStack.push(std::move(event));
+			m_Transaction->Add(std::move(event));
+			return;
 		}
-		else
+
+		auto Top = m_UndoStack.top();
+
+		//continuation of the top event, only keep its after-image
+		if (Top && Top != event.get() && m_RedoStack.empty() &&
+			m_CoalesceWindow.count() > 0 &&
+			event->GetTimeStamp() - Top->GetTimeStamp() <= m_CoalesceWindow &&
+			Top->MergeWith(*event))
+		{
+			m_UndoStack.UpdateTopSize();
+
+			wxCommandEvent CmdEvt(ssEVT_WB_UNDOREDO, GetId());
+			CmdEvt.SetEventObject(this);
+			ProcessWindowEvent(CmdEvt);
+
+			return;
+		}
+
+		//Check if current event and event on the top of redo stack are the same
+		if (Top != event.get())
 			m_UndoStack.push(std::move(event));
 
 		//At any undoable event that is pushed onto stack, clear Redo stack
-		std::stack<std::unique_ptr<grid::WSUndoRedoEvent>>().swap(m_RedoStack);
+		m_RedoStack.clear();
+
+		EnforceUndoLimits();
 
 		wxCommandEvent CmdEvt(ssEVT_WB_UNDOREDO, GetId());
 		CmdEvt.SetEventObject(this);
@@ -82,21 +120,69 @@ namespace grid
 	}
 
 
+	void CWorkbookBase::SetUndoLimits(size_t MaxBytes, size_t MaxEntries)
+	{
+		m_UndoMaxBytes = MaxBytes;
+		m_UndoMaxEntries = MaxEntries;
+
+		EnforceUndoLimits();
+	}
+
+
+	void CWorkbookBase::EnforceUndoLimits()
+	{
+		auto Exceeds = [this]()
+		{
+			return (m_UndoMaxBytes > 0 && GetUndoMemoryUsage() > m_UndoMaxBytes) ||
+				(m_UndoMaxEntries > 0 && m_UndoStack.size() + m_RedoStack.size() > m_UndoMaxEntries);
+		};
+
+		//oldest undo events go first, redo history is cleared by the next push anyway
+		while (Exceeds() && m_UndoStack.size() > 1)
+		{
+			m_UndoStack.pop_oldest();
+			m_NumEvicted++;
+		}
+	}
+
+
+	bool CWorkbookBase::ApplyEvent(WSUndoRedoEvent* UndoRedoEvt, bool Undo)
+	{
+		try
+		{
+			if (Undo)
+				UndoRedoEvt->Undo();
+			else
+				UndoRedoEvt->Redo();
+		}
+		catch (std::exception& e)
+		{
+			wxMessageBox(wxString(Undo ? "Cannot undo: " : "Cannot redo: ") + e.what(), "Error", wxOK | wxICON_WARNING);
+			return false;
+		}
+
+		return true;
+	}
+
+
 	void CWorkbookBase::ProcessUndoEvent()
 	{
-		if (m_UndoStack.empty())
+		if (m_UndoStack.empty() || IsInTransaction())
 			return;
 
-		auto UndoRedoEvt = std::move(m_UndoStack.top());
-		UndoRedoEvt->Undo();
+		auto UndoRedoEvt = m_UndoStack.pop();
+
+		//the event stays in the undo history
+		if (!ApplyEvent(UndoRedoEvt.get(), true))
+		{
+			m_UndoStack.push(std::move(UndoRedoEvt));
+			return;
+		}
 
 		//If it is a redoable event then push it onto redo stack
 		if (UndoRedoEvt->CanRedo())
 			m_RedoStack.push(std::move(UndoRedoEvt));
 
-		//We are done, pop it from Undo
-		m_UndoStack.pop();
-
 		wxCommandEvent CmdEvt(ssEVT_WB_UNDOREDO, GetId());
 		CmdEvt.SetEventObject(this);
 		ProcessWindowEvent(CmdEvt);
@@ -106,17 +192,275 @@ namespace grid
 
 	void CWorkbookBase::ProcessRedoEvent()
 	{
-		if (m_RedoStack.empty())
+		if (m_RedoStack.empty() || IsInTransaction())
 			return;
 
-		auto UndoRedoEvt = std::move(m_RedoStack.top());
-		UndoRedoEvt->Redo();
+		auto UndoRedoEvt = m_RedoStack.pop();
+
+		if (!ApplyEvent(UndoRedoEvt.get(), false))
+		{
+			m_RedoStack.push(std::move(UndoRedoEvt));
+			return;
+		}
 
 		//Every redoable event can be undone, therefore, push it onto Undo stack
 		m_UndoStack.push(std::move(UndoRedoEvt));
 
-		//We are done, pop it from Redo
-		m_RedoStack.pop();
+		wxCommandEvent CmdEvt(ssEVT_WB_UNDOREDO, GetId());
+		CmdEvt.SetEventObject(this);
+		ProcessWindowEvent(CmdEvt);
+	}
+
+
+	void CWorkbookBase::RecordValueChange(
+		CWorksheetBase* worksheet,
+		int row,
+		int col,
+		const wxString& OldValue,
+		const wxString& NewValue)
+	{
+		if (!m_Transaction || OldValue == NewValue)
+			return;
+
+		m_Transaction->AddValueChange(worksheet, row, col, OldValue.ToStdWstring(), NewValue.ToStdWstring());
+	}
+
+
+	void CWorkbookBase::SuspendNotifications()
+	{
+		if (m_SuspendDepth++ > 0 || !m_WSNtbk)
+			return;
+
+		for (size_t i = 0; i < m_WSNtbk->GetPageCount(); i++)
+		{
+			auto ws = m_WSNtbk->FindWorksheet(i);
+			if (ws)
+			{
+				ws->BeginBatch();
+				m_BatchedSheets.insert(ws);
+			}
+		}
+	}
+
+
+	void CWorkbookBase::ResumeNotifications()
+	{
+		if (m_SuspendDepth == 0 || --m_SuspendDepth > 0)
+			return;
+
+		for (auto ws : m_BatchedSheets)
+			ws->EndBatch();
+		m_BatchedSheets.clear();
+
+		auto DirtySheets = std::move(m_DirtySheets);
+		m_DirtySheets.clear();
+
+		//each worksheet notifies once, workbook collects them and notifies once
+		m_FlushingDirty = true;
+		for (auto ws : DirtySheets)
+			ws->MarkDirty();
+		m_FlushingDirty = false;
+
+		if (m_DeferredDirty)
+		{
+			m_DeferredDirty = false;
+			MarkDirty();
+		}
+	}
+
+
+	bool CWorkbookBase::DeferDirty(CWorksheetBase* worksheet)
+	{
+		if (m_SuspendDepth == 0)
+			return false;
+
+		m_DirtySheets.insert(worksheet);
+		return true;
+	}
+
+
+	void CWorkbookBase::BeginTransaction(const std::wstring& Label, CWorksheetBase* worksheet)
+	{
+		if (m_TransactionDepth++ > 0)
+			return;
+
+		m_Transaction = std::make_unique<TransactionEvent>(this, worksheet ? worksheet : GetActiveWS(), Label);
+		m_RollbackRequested = false;
+
+		SuspendNotifications();
+	}
+
+
+	void CWorkbookBase::EndTransaction(bool Commit)
+	{
+		if (m_TransactionDepth == 0)
+			return;
+
+		if (!Commit)
+			m_RollbackRequested = true;
+
+		if (--m_TransactionDepth > 0)
+			return;
+
+		auto evt = std::move(m_Transaction);
+		bool Rollback = m_RollbackRequested;
+		m_RollbackRequested = false;
+
+		//might be called from ~CTransaction during unwinding, nothing must escape
+		if (Rollback)
+		{
+			try {
+				evt->Undo();
+			}
+			catch (std::exception& e)
+			{
+				//edits are still there (undo is all or nothing), they can be undone later
+				wxMessageBox(wxString("Changes cannot be rolled back: ") + e.what(), "Error", wxOK | wxICON_WARNING);
+				Rollback = false;
+			}
+			catch (...)
+			{
+				wxMessageBox("Changes cannot be rolled back.", "Error", wxOK | wxICON_WARNING);
+				Rollback = false;
+			}
+		}
+
+		if (!Rollback && !evt->empty())
+			PushUndoEvent(std::move(evt));
+
+		ResumeNotifications();
+	}
+
+
+	void CWorkbookBase::ForgetWorksheet(CWorksheetBase* worksheet)
+	{
+		m_BatchedSheets.erase(worksheet);
+		m_DirtySheets.erase(worksheet);
+	}
+
+
+	void CWorkbookBase::UndoTo(size_t Count)
+	{
+		if (Count == 0 || m_UndoStack.empty() || IsInTransaction())
+			return;
+
+		BeginReplay();
+
+		for (size_t i = 0; i < Count && !m_UndoStack.empty(); ++i)
+		{
+			auto UndoRedoEvt = m_UndoStack.pop();
+
+			//stops at the event that cannot be undone
+			if (!ApplyEvent(UndoRedoEvt.get(), true))
+			{
+				m_UndoStack.push(std::move(UndoRedoEvt));
+				break;
+			}
+
+			if (UndoRedoEvt->CanRedo())
+				m_RedoStack.push(std::move(UndoRedoEvt));
+		}
+
+		EndReplay();
+	}
+
+
+	void CWorkbookBase::RedoTo(size_t Count)
+	{
+		if (Count == 0 || m_RedoStack.empty() || IsInTransaction())
+			return;
+
+		BeginReplay();
+
+		for (size_t i = 0; i < Count && !m_RedoStack.empty(); ++i)
+		{
+			auto UndoRedoEvt = m_RedoStack.pop();
+
+			if (!ApplyEvent(UndoRedoEvt.get(), false))
+			{
+				m_RedoStack.push(std::move(UndoRedoEvt));
+				break;
+			}
+
+			m_UndoStack.push(std::move(UndoRedoEvt));
+		}
+
+		EndReplay();
+	}
+
+
+	void CWorkbookBase::RecordReplaySheet(CWorksheetBase* worksheet)
+	{
+		if (worksheet->GetWSId() == m_Replay.m_WSId)
+			return;
+
+		//only the blocks on the last worksheet are shown
+		m_Replay.m_WSId = worksheet->GetWSId();
+		m_Replay.m_HasBlock = false;
+	}
+
+
+	void CWorkbookBase::RecordReplayBlock(
+		CWorksheetBase* worksheet,
+		const wxGridCellCoords& TL,
+		const wxGridCellCoords& BR)
+	{
+		RecordReplaySheet(worksheet);
+
+		if (!m_Replay.m_HasBlock)
+		{
+			m_Replay.m_TL = TL;
+			m_Replay.m_BR = BR;
+			m_Replay.m_HasBlock = true;
+
+			return;
+		}
+
+		m_Replay.m_TL = wxGridCellCoords(
+			std::min(m_Replay.m_TL.GetRow(), TL.GetRow()), 
+			std::min(m_Replay.m_TL.GetCol(), TL.GetCol()));
+		
+		m_Replay.m_BR = wxGridCellCoords(
+			std::max(m_Replay.m_BR.GetRow(), BR.GetRow()),
+			std::max(m_Replay.m_BR.GetCol(), BR.GetCol()));
+	}
+
+
+	void CWorkbookBase::BeginReplay()
+	{
+		m_Replay = ReplayState();
+		m_Replay.m_Active = true;
+
+		SuspendNotifications();
+	}
+
+
+	void CWorkbookBase::EndReplay()
+	{
+		m_Replay.m_Active = false;
+
+		//still in batch mode, therefore painted once when notifications are resumed
+		auto ws = GetWorksheetById(m_Replay.m_WSId);
+		if (ws)
+		{
+			if (ws != GetActiveWS())
+				ShowWorksheet(ws);
+
+			if (m_Replay.m_HasBlock)
+			{
+				if (m_Replay.m_TL == m_Replay.m_BR)
+				{
+					if (ws->IsSelection())
+						ws->ClearSelection();
+
+					ws->GoToCell(m_Replay.m_TL);
+				}
+				else
+					ws->SelectBlock(m_Replay.m_TL, m_Replay.m_BR);
+			}
+		}
+
+		ResumeNotifications();
 
 		wxCommandEvent CmdEvt(ssEVT_WB_UNDOREDO, GetId());
 		CmdEvt.SetEventObject(this);
@@ -148,8 +492,35 @@ namespace grid
 	}
 
 
+	void CWorkbookBase::SetSpillOptions(size_t Threshold, const std::filesystem::path& Dir)
+	{
+		m_SpillThreshold = Threshold;
+		m_SpillDir = Dir;
+	}
+
+
+	std::filesystem::path CWorkbookBase::GetSpillDirectory() const
+	{
+		if (m_SpillThreshold == 0)
+			return {};
+
+		if (!m_SpillDir.empty())
+			return m_SpillDir;
+
+		if (!m_SnapshotDir.empty())
+			return m_SnapshotDir / "undo";
+
+		std::error_code ec;
+		auto TempDir = std::filesystem::temp_directory_path(ec);
+		
+		return ec ? std::filesystem::path() : TempDir / "undo";
+	}
+
+
 	bool CWorkbookBase::Write(const std::filesystem::path& SnapshotDir)
 	{
+		m_SnapshotDir = SnapshotDir;
+
 		std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
 
 		std::stringstream XML;
@@ -209,6 +580,8 @@ namespace grid
 
 	bool CWorkbookBase::Read(const std::filesystem::path& SnapshotDir)
 	{
+		m_SnapshotDir = SnapshotDir;
+
 		wxFile file;
 		file.Open((SnapshotDir / "workbook.xml").wstring());
 
@@ -271,6 +644,13 @@ namespace grid
 	void CWorkbookBase::MarkDirty()
 	{
 		m_IsDirty = true;
+
+		//notified once when resumed
+		if (m_SuspendDepth > 0 || m_FlushingDirty)
+		{
+			m_DeferredDirty = true;
+			return;
+		}
 		
 		wxCommandEvent evt(ssEVT_WB_DIRTY, GetId());
 		evt.SetEventObject(this);
@@ -318,16 +698,14 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 
-		auto alignEvt = std::make_unique<grid::CellAlignmentChangedEvent>(ws);
-		alignEvt->m_TL = TL;
-		alignEvt->m_BR = BR;
-		alignEvt->m_InitVal = ws->GetBlock(TL, BR);
+		auto alignEvt = std::make_unique<grid::CellAlignmentChangedEvent>(ws, TL, BR);
+		alignEvt->SetInitial();
 
 		//Change
 		ws->SetBlockCellAlignment(TL, BR, wxAlignID);
 
 		//After change
-		alignEvt->m_LastVal = ws->GetBlock(TL, BR);
+		alignEvt->SetFinal();
 
 		PushUndoEvent(std::move(alignEvt));
 
@@ -342,16 +720,14 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 
-		auto evt = std::make_unique<grid::CellBGColorChangedEvent>(ws);
-		evt->m_TL = TL;
-		evt->m_BR = BR;
-		evt->m_InitVal = ws->GetBlock(TL, BR);
+		auto evt = std::make_unique<grid::CellBGColorChangedEvent>(ws, TL, BR);
+		evt->SetInitial();
 
 		//Change
 		ws->SetBlockBackgroundColor(TL, BR, BGColor);
 
 		//After change
-		evt->m_LastVal = ws->GetBlock(TL, BR);
+		evt->SetFinal();
 
 		PushUndoEvent(std::move(evt));
 
@@ -366,16 +742,14 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 		
-		auto evt = std::make_unique<grid::TextColorChangedEvent>(ws);
-		evt->m_TL = TL;
-		evt->m_BR = BR;
-		evt->m_InitVal = ws->GetBlock(TL, BR);
+		auto evt = std::make_unique<grid::TextColorChangedEvent>(ws, TL, BR);
+		evt->SetInitial();
 
 		//Change
 		ws->SetBlockTextColour(TL, BR, TxtColor);
 
 		//After change
-		evt->m_LastVal = ws->GetBlock(TL, BR);
+		evt->SetFinal();
 
 		PushUndoEvent(std::move(evt));
 		
@@ -390,11 +764,9 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 
-		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws);
-		fntChanged->m_InitVal = ws->GetBlock(TL, BR);
-		fntChanged->m_TL = TL;
-		fntChanged->m_BR = BR;
-		fntChanged->m_FontProperty = "size";
+		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws, TL, BR);
+		fntChanged->m_Property = "size";
+		fntChanged->SetInitial();
 
 		//Change the font
 		for (int i = TL.GetRow(); i <= BR.GetRow(); i++)
@@ -411,7 +783,7 @@ namespace grid
 		}
 
 		//Font already changed
-		fntChanged->m_LastVal = ws->GetBlock(TL, BR);
+		fntChanged->SetFinal();
 
 		PushUndoEvent(std::move(fntChanged));
 
@@ -426,11 +798,9 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 
-		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws);
-		fntChanged->m_InitVal = ws->GetBlock(TL, BR);
-		fntChanged->m_TL = TL;
-		fntChanged->m_BR = BR;
-		fntChanged->m_FontProperty = "bold";
+		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws, TL, BR);
+		fntChanged->m_Property = "bold";
+		fntChanged->SetInitial();
 
 
 		//Font is changing
@@ -450,7 +820,7 @@ namespace grid
 		}
 
 		//Font already changed
-		fntChanged->m_LastVal = ws->GetBlock(TL, BR);
+		fntChanged->SetFinal();
 
 		PushUndoEvent(std::move(fntChanged));
 
@@ -467,11 +837,9 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 
-		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws);
-		fntChanged->m_InitVal = ws->GetBlock(TL, BR);
-		fntChanged->m_TL = TL;
-		fntChanged->m_BR = BR;
-		fntChanged->m_FontProperty = "italic";
+		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws, TL, BR);
+		fntChanged->m_Property = "italic";
+		fntChanged->SetInitial();
 
 
 		//Font is changing
@@ -491,7 +859,7 @@ namespace grid
 		}
 
 		//Font already changed
-		fntChanged->m_LastVal = ws->GetBlock(TL, BR);
+		fntChanged->SetFinal();
 
 		PushUndoEvent(std::move(fntChanged));
 
@@ -507,11 +875,9 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 
-		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws);
-		fntChanged->m_InitVal = ws->GetBlock(TL, BR);
-		fntChanged->m_TL = TL;
-		fntChanged->m_BR = BR;
-		fntChanged->m_FontProperty = "underlined";
+		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws, TL, BR);
+		fntChanged->m_Property = "underlined";
+		fntChanged->SetInitial();
 
 		//Font is changing
 		for (int i = TL.GetRow(); i <= BR.GetRow(); i++) 
@@ -530,7 +896,7 @@ namespace grid
 		}
 
 		//Font already changed
-		fntChanged->m_LastVal = ws->GetBlock(TL, BR);
+		fntChanged->SetFinal();
 
 		PushUndoEvent(std::move(fntChanged));
 
@@ -548,11 +914,9 @@ namespace grid
 		auto ws = GetActiveWS();
 		const auto& [TL, BR] = GetSelectionCoords();
 
-		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws);
-		fntChanged->m_InitVal = ws->GetBlock(TL, BR);
-		fntChanged->m_TL = TL;
-		fntChanged->m_BR = BR;
-		fntChanged->m_FontProperty = "face";
+		auto fntChanged = std::make_unique<grid::FontChangedEvent>(ws, TL, BR);
+		fntChanged->m_Property = "face";
+		fntChanged->SetInitial();
 
 		//Change the font
 		for (int i = TL.GetRow(); i <= BR.GetRow(); i++)
@@ -567,7 +931,7 @@ namespace grid
 		}
 
 		//Font already changed
-		fntChanged->m_LastVal = ws->GetBlock(TL, BR);
+		fntChanged->SetFinal();
 
 		PushUndoEvent(std::move(fntChanged));
 
@@ -577,21 +941,32 @@ namespace grid
 	}
 
 
-	bool CWorkbookBase::PasteValues(const wxDataFormat& ClipbrdFormat)
+	bool CWorkbookBase::PasteValues(const wxDataFormat& ClipbrdFormat, bool Transpose)
 	{
 		auto ws = GetActiveWS();
 		auto evt = std::make_unique<grid::DataPasted>(ws);
 
 		std::pair<wxGridCellCoords, wxGridCellCoords> Coords;
+		std::vector<Cell> Overwritten;
 		
-		if (ClipbrdFormat == XMLDataFormat())
-			Coords = ws->Paste_XMLDataFormat(CWorksheetBase::PASTE::VALUES);
+		//binary and XML formats carry the same content, binary is preferred when available
+		if ((ClipbrdFormat == BinaryDataFormat() || ClipbrdFormat == XMLDataFormat()) && SupportsBinary())
+			Coords = ws->Paste_BinaryDataFormat(CWorksheetBase::PASTE::VALUES, Transpose, &Overwritten);
+
+		else if (ClipbrdFormat == XMLDataFormat())
+			Coords = ws->Paste_XMLDataFormat(CWorksheetBase::PASTE::VALUES, Transpose, &Overwritten);
 
 		else if (ClipbrdFormat == wxDF_TEXT)
-			Coords = ws->Paste_TextValues();
+			Coords = ws->Paste_TextValues(Transpose, &Overwritten);
+
+		if (Coords.first.GetRow() < 0 || Coords.first.GetCol() < 0)
+			return false;
 		
 		evt->SetPaste((int)CWorksheetBase::PASTE::VALUES);
 		evt->SetCoords(Coords.first, Coords.second);
+		evt->SetInitialCells(std::move(Overwritten));
+		evt->SetFinalCells(ws->GetPopulatedCells(Coords.first, Coords.second));
+		evt->SetInferTypes(ClipbrdFormat == wxDF_TEXT);
 
 		PushUndoEvent(std::move(evt));
 
@@ -601,16 +976,27 @@ namespace grid
 
 	bool CWorkbookBase::PasteFormat(const wxDataFormat& ClipbrdFormat, bool RefreshBlock)
 	{
-		if (ClipbrdFormat != XMLDataFormat())
+		if (ClipbrdFormat != XMLDataFormat() && ClipbrdFormat != BinaryDataFormat())
 			return false;
 
 		auto ws = GetActiveWS();
 
-		auto evt = std::make_unique<grid::DataPasted>(ws);		
-		auto Coords = ws->Paste_XMLDataFormat(CWorksheetBase::PASTE::FORMAT);
+		auto evt = std::make_unique<grid::DataPasted>(ws);
+
+		std::vector<Cell> Overwritten;
+
+		//binary and XML formats carry the same content, binary is preferred when available
+		auto Coords = SupportsBinary() ?
+			ws->Paste_BinaryDataFormat(CWorksheetBase::PASTE::FORMAT, false, &Overwritten) :
+			ws->Paste_XMLDataFormat(CWorksheetBase::PASTE::FORMAT, false, &Overwritten);
+
+		if (Coords.first.GetRow() < 0 || Coords.first.GetCol() < 0)
+			return false;
 		
 		evt->SetPaste((int)CWorksheetBase::PASTE::FORMAT);
 		evt->SetCoords(Coords.first, Coords.second);
+		evt->SetInitialCells(std::move(Overwritten));
+		evt->SetFinalCells(ws->GetPopulatedCells(Coords.first, Coords.second));
 
 		PushUndoEvent(std::move(evt));
 
@@ -619,4 +1005,99 @@ namespace grid
 
 		return true;
 	}
-}
\ No newline at end of file
+
+
+
+
+	std::vector<FindMatch> CWorkbookBase::FindAll(const FindOptions& Options)
+	{
+		CMatcher Matcher(Options);
+		return ScanWorkbook(this, Matcher).m_Matches;
+	}
+
+
+	size_t CWorkbookBase::ReplaceAll(const FindOptions& Options, const wxString& Replacement)
+	{
+		CMatcher Matcher(Options);
+
+		//new values are computed on the worker threads as well
+		auto Result = ScanWorkbook(this, Matcher, &Replacement);
+
+		const auto& Matches = Result.m_Matches;
+
+		size_t NChanged = 0;
+
+		//matches are ordered by page, each worksheet is one transaction
+		for (size_t First = 0; First < Matches.size();)
+		{
+			size_t WSId = Matches[First].m_WSId;
+
+			size_t Last = First;
+			while (Last < Matches.size() && Matches[Last].m_WSId == WSId)
+				++Last;
+
+			auto ws = GetWorksheetById(WSId);
+
+			CTransaction Transaction(this, L"Replace", ws);
+
+			for (size_t i = First; i < Last; ++i)
+			{
+				const auto& Coord = Matches[i].m_Coord;
+				if (ws->GetCellValue(Coord.GetRow(), Coord.GetCol()) == Result.m_NewValues[i])
+					continue;
+
+				ws->SetCellValue(Coord.GetRow(), Coord.GetCol(), Result.m_NewValues[i], false);
+				NChanged++;
+			}
+
+			ws->MarkDirty();
+
+			First = Last;
+		}
+
+		return NChanged;
+	}
+
+
+	/*******************************************************************/
+
+	CTransaction::CTransaction(
+		CWorkbookBase* workbook, 
+		const std::wstring& Label, 
+		CWorksheetBase* worksheet) :
+		m_Workbook{ workbook }, m_NumExceptions{ std::uncaught_exceptions() }
+	{
+		if (m_Workbook)
+			m_Workbook->BeginTransaction(Label, worksheet);
+	}
+
+
+	CTransaction::~CTransaction()
+	{
+		//an exception thrown inside the transaction's scope
+		if (std::uncaught_exceptions() > m_NumExceptions)
+			Rollback();
+		else
+			Commit();
+	}
+
+
+	void CTransaction::Commit()
+	{
+		if (!m_Workbook)
+			return;
+
+		m_Workbook->EndTransaction(true);
+		m_Workbook = nullptr;
+	}
+
+
+	void CTransaction::Rollback()
+	{
+		if (!m_Workbook)
+			return;
+
+		m_Workbook->EndTransaction(false);
+		m_Workbook = nullptr;
+	}
+}
@@ -2,12 +2,15 @@
 
 #include <string>
 #include <filesystem>
-#include <stack>
 #include <memory>
+#include <set>
+#include <chrono>
+#include <exception>
 #include <wx/wx.h>
 #include <wx/grid.h>
 #include <wx/clipbrd.h>
 
+#include "undohistory.h"
 #include "dllimpexp.h"
 
 namespace grid
@@ -15,10 +18,14 @@ namespace grid
 	class CWorksheetNtbkBase;
 	class CWorksheetBase;
 	class WSUndoRedoEvent;
+	class TransactionEvent;
+	struct FindOptions;
+	struct FindMatch;
 
 	class DLLGRID CWorkbookBase : public wxPanel
 	{
 		friend class CWorksheetNtbkBase;
+		friend class CTransaction;
 	public:
 
 		CWorkbookBase(wxWindow* parent);
@@ -36,8 +43,94 @@ namespace grid
 							int ncols = 50);
 
 
+		/*
+			If the event continues the one on top of the undo stack (same worksheet, same cells 
+			and same attribute) and arrives within the coalescing window, the two are merged.
+		*/
 		void PushUndoEvent(std::unique_ptr<WSUndoRedoEvent> event);
 
+		//0 disables merging of successive events
+		void SetCoalesceWindow(std::chrono::milliseconds Window) {
+			m_CoalesceWindow = Window;
+		}
+
+		/*
+			Oldest undo events are evicted when either limit is exceeded (0 means no limit, the default).
+			The most recent event is always kept.
+		*/
+		void SetUndoLimits(size_t MaxBytes, size_t MaxEntries);
+
+		//memory used by undo and redo history in bytes
+		size_t GetUndoMemoryUsage() const {
+			return m_UndoStack.GetMemorySize() + m_RedoStack.GetMemorySize();
+		}
+
+		//number of undo events evicted so far to stay within the limits
+		size_t GetNumEvictedUndo() const {
+			return m_NumEvicted;
+		}
+
+		/*
+			Undo payloads larger than Threshold bytes are compressed and written to Dir.
+			If Dir is empty, the "undo" folder of the snapshot directory (or temp directory) is used.
+			Threshold = 0 disables spilling.
+		*/
+		void SetSpillOptions(size_t Threshold, const std::filesystem::path& Dir = {});
+
+		//empty path if spilling is disabled
+		std::filesystem::path GetSpillDirectory() const;
+
+		size_t GetSpillThreshold() const {
+			return m_SpillThreshold;
+		}
+
+		bool IsInTransaction() const {
+			return m_Transaction != nullptr;
+		}
+
+		//called by worksheets to record a cell value change while a transaction is open
+		void RecordValueChange(
+			CWorksheetBase* worksheet, 
+			int row, 
+			int col, 
+			const wxString& OldValue, 
+			const wxString& NewValue);
+
+		/*
+			Until resumed: all worksheets are in batch mode and dirty notifications are collected.
+			When resumed, each dirty worksheet and the workbook notify once.
+			Can be nested.
+		*/
+		void SuspendNotifications();
+		void ResumeNotifications();
+
+		bool IsNotificationSuspended() const {
+			return m_SuspendDepth > 0;
+		}
+
+		//if notifications are suspended, records the worksheet as dirty and returns true
+		bool DeferDirty(CWorksheetBase* worksheet);
+
+		/*
+			Undoes (redoes) the Count most recent events as a single jump:
+			grid repaints and dirty notifications are suspended, the blocks the events
+			touched are merged and selected, and the worksheets are refreshed once at the end.
+		*/
+		void UndoTo(size_t Count);
+		void RedoTo(size_t Count);
+
+		//true while UndoTo or RedoTo is applying events
+		bool IsReplaying() const {
+			return m_Replay.m_Active;
+		}
+
+		//called by events during replay instead of showing the worksheet or selecting the block
+		void RecordReplaySheet(CWorksheetBase* worksheet);
+		void RecordReplayBlock(
+			CWorksheetBase* worksheet, 
+			const wxGridCellCoords& TL, 
+			const wxGridCellCoords& BR);
+
 		void EnableEditing(bool Enable = true);
 
 		void TurnOnGridSelectionMode(bool IsOn = true);
@@ -59,13 +152,25 @@ namespace grid
 
 		CWorksheetBase* GetWorksheet(const size_t PageNumber) const;
 
-		//if paste is successful returns true
-		bool PasteValues(const wxDataFormat& ClipbrdFormat);
+		//nullptr if there is no worksheet with the id (i.e., removed)
+		CWorksheetBase* GetWorksheetById(size_t Id) const;
+
+		//if paste is successful returns true (rows become columns if Transpose)
+		bool PasteValues(const wxDataFormat& ClipbrdFormat, bool Transpose = false);
 		bool PasteFormat(const wxDataFormat& ClipbrdFormat, bool RefreshBlock = true);
 
 		//return number of worksheets
 		size_t size() const;
 
+		/*
+			Cells of all worksheets matching Options, ordered by page then row then column.
+			Sends ssEVT_WB_FINDPROGRESS while the scan runs.
+		*/
+		std::vector<FindMatch> FindAll(const FindOptions& Options);
+
+		//Replaces the matches, each worksheet's replacements are one undo step. Returns the number of cells changed.
+		size_t ReplaceAll(const FindOptions& Options, const wxString& Replacement);
+
 		auto& GetRedoStack() const{
 			return m_RedoStack;
 		}
@@ -104,6 +209,9 @@ namespace grid
 		void ProcessRedoEvent();
 
 	private:
+		//Undoes (redoes) the event, warns the user and returns false if it failed (i.e. spilled cells cannot be read)
+		bool ApplyEvent(WSUndoRedoEvent* UndoRedoEvt, bool Undo);
+
 		//Gets the TL and BR of selection coord (if no selection returns GridCursorRow and TL=BR)
 		std::pair<wxGridCellCoords, wxGridCellCoords> GetSelectionCoords() const;
 
@@ -112,7 +220,118 @@ namespace grid
 		bool m_IsDirty = false;
 
 	private:
-		std::stack<std::unique_ptr<WSUndoRedoEvent>> m_UndoStack, m_RedoStack;
+		//evicts oldest undo events until history fits into limits
+		void EnforceUndoLimits();
+
+		void BeginReplay();
+		void EndReplay();
+
+		//the undo event belongs to worksheet (active worksheet if null)
+		void BeginTransaction(const std::wstring& Label, CWorksheetBase* worksheet);
+		void EndTransaction(bool Commit);
+
+		//the worksheet is being removed
+		void ForgetWorksheet(CWorksheetBase* worksheet);
+
+	private:
+		UndoHistory m_UndoStack, m_RedoStack;
+
+		//unbounded unless SetUndoLimits is called
+		size_t m_UndoMaxBytes{ 0 };
+		size_t m_UndoMaxEntries{ 0 };
+		size_t m_NumEvicted{ 0 };
+
+		std::chrono::milliseconds m_CoalesceWindow{ 1000 };
+
+		//set by Read or Write
+		std::filesystem::path m_SnapshotDir;
+
+		std::filesystem::path m_SpillDir;
+		size_t m_SpillThreshold{ 16 * 1024 * 1024 };
+
+		std::unique_ptr<TransactionEvent> m_Transaction;
+		int m_TransactionDepth{ 0 };
+		bool m_RollbackRequested{ false };
+
+		int m_SuspendDepth{ 0 };
+		std::set<CWorksheetBase*> m_BatchedSheets, m_DirtySheets;
+		bool m_DeferredDirty{ false }; //workbook itself
+		bool m_FlushingDirty{ false };
+
+		struct ReplayState
+		{
+			bool m_Active{ false };
+			size_t m_WSId{ 0 }; //last worksheet an event was applied to
+			bool m_HasBlock{ false };
+			wxGridCellCoords m_TL, m_BR; //union of the blocks on m_WSId
+		};
+
+		ReplayState m_Replay;
+	};
+
+
+
+	/*
+		Groups the edits made during its lifetime into a single undo event.
+		Dirty notifications are fired once and worksheets are repainted once at commit.
+		Nested transactions become part of the outermost one.
+		
+		{
+			CTransaction Tr(workbook, L"import");
+			ws->SetCellValue(...);
+			...
+		} //commits, or rolls back if left by an exception
+	*/
+	class DLLGRID CTransaction
+	{
+	public:
+		//the undo event belongs to worksheet, the active one if null (a nested transaction keeps the outermost one's)
+		CTransaction(
+			CWorkbookBase* workbook, 
+			const std::wstring& Label = L"", 
+			CWorksheetBase* worksheet = nullptr);
+		
+		//commits unless Commit or Rollback was called, rolls back if the stack is being unwound
+		~CTransaction();
+
+		CTransaction(const CTransaction&) = delete;
+		CTransaction& operator=(const CTransaction&) = delete;
+
+		void Commit();
+
+		//Reverts the changes (rolling back a nested transaction reverts the outermost one)
+		void Rollback();
+
+	private:
+		CWorkbookBase* m_Workbook{ nullptr };
+
+		//uncaught exceptions when constructed
+		int m_NumExceptions{ 0 };
+	};
+
+
+
+	//suspends the notifications of workbook (see SuspendNotifications) during its lifetime, workbook can be null
+	class DLLGRID CNotificationsSuspended
+	{
+	public:
+		CNotificationsSuspended(CWorkbookBase* workbook) :m_Workbook{ workbook }
+		{
+			if (m_Workbook)
+				m_Workbook->SuspendNotifications();
+		}
+
+		~CNotificationsSuspended()
+		{
+			if (m_Workbook)
+				m_Workbook->ResumeNotifications();
+		}
+
+		CNotificationsSuspended(const CNotificationsSuspended&) = delete;
+		CNotificationsSuspended& operator=(const CNotificationsSuspended&) = delete;
+
+	private:
+		CWorkbookBase* m_Workbook{ nullptr };
 	};
 }
 
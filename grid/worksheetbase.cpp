@@ -1,6 +1,7 @@
 #include "worksheetbase.h"
 
 #include <algorithm>
+#include <atomic>
 #include <set>
 #include <wx/wx.h>
 #include <wx/file.h>
@@ -17,6 +18,9 @@
 #include "workbookbase.h"
 
 #include "events.h"
+#include "selstats.h"
+#include "valueindex.h"
+#include "typeinfer.h"
 
 
 //events by selection rectangle
@@ -42,6 +46,12 @@ static bool SourceOverlap(
 
 namespace grid
 {
+	static size_t NewWorksheetId()
+	{
+		static std::atomic<size_t> LastId{ 0 };
+		return ++LastId;
+	}
+
 
 	CWorksheetBase::CWorksheetBase(wxWindow* parent,
 		wxWindowID id,
@@ -55,6 +65,8 @@ namespace grid
 
 		CreateGrid(nrows, ncols);
 
+		m_Id = NewWorksheetId();
+		m_SelStats = std::make_unique<CSelectionStats>(this);
 		m_WSName = WindowName;
 		m_IsDirty = false;
 
@@ -131,6 +143,10 @@ namespace grid
 		m_ColWndRect = ColRect;
 		m_RowWndRect = RowRect;
 
+		//selection is not yet changed when the event is sent
+		if (event.Selecting())
+			m_SelStats->Update(event.GetTopLeftCoords(), event.GetBottomRightCoords());
+
 		event.Skip();
 	}
 
@@ -138,7 +154,10 @@ namespace grid
 	void CWorksheetBase::OnRangeSelected(wxGridRangeSelectEvent& event)
 	{
 		if (event.Selecting() == false)
+		{
+			m_SelStats->Clear();
 			return;
+		}
 
 		const wxGridCellCoordsArray& btl(GetSelectionBlockTopLeft());
 
@@ -147,6 +166,7 @@ namespace grid
 		{
 			wxMessageBox("Only one block/region can be selected.");
 			ClearSelection();
+			m_SelStats->Clear();
 
 			//make sure to return here as ClearSelection will cause ncols/nrows to have std::nullopt
 			return;
@@ -155,10 +175,15 @@ namespace grid
 		size_t ncols = GetNumSelCols(), nrows = GetNumSelRows();
 
 		if (ncols == 1 && nrows == 1)
+		{
 			ClearSelection();
+			m_SelStats->Clear();
+		}
 
 		if (ncols > 1 || nrows > 1)
 		{
+			m_SelStats->Update(GetSelTopLeft(), GetSelBtmRight());
+
 			int col = GetSelTopLeft().GetCol();
 			wxRect ColRect(GetColLeft(col), 0, ncols * GetColWidth(col), GetColLabelSize());
 
@@ -264,21 +289,21 @@ namespace grid
 		auto evt = std::make_unique<RowsDeleted>(this);
 		evt->SetInfo(PosRowStart, NRows);
 
-		auto CheckSet = [&](const GridSet& aSet)->void
+		//a cell can be both in content and format, collect each only once
+		GridSet Coords;
+		for (const GridSet* aSet : { &m_Content, &m_Format })
 		{
-			std::vector<Cell> InitCells;
-
-			for (const auto& Coord : aSet)
-			{
-				if (Coord.GetRow() >= PosRowStart && Coord.GetRow() < PosRowStart + NRows)
-					InitCells.push_back(GetAsCellObject(Coord));
-			}
+			auto it = aSet->lower_bound(wxGridCellCoords(PosRowStart, 0));
+			for (; it != aSet->end() && it->GetRow() < PosRowStart + NRows; ++it)
+				Coords.insert(*it);
+		}
 
-			evt->SetInitialCells(InitCells);
-		};
+		std::vector<Cell> InitCells;
+		InitCells.reserve(Coords.size());
+		for (const auto& Coord : Coords)
+			InitCells.push_back(GetAsCellObject(Coord));
 
-		CheckSet(m_Content);
-		CheckSet(m_Format);
+		evt->SetInitialCells(std::move(InitCells));
 
 		//Deletion 
 		DeleteRows(PosRowStart, NRows, true);
@@ -312,21 +337,23 @@ namespace grid
 		auto evt = std::make_unique<ColumnsDeleted>(this);
 		evt->SetInfo(PosColStart, NCols);
 
-		auto CheckSet = [&](const GridSet& aSet)
+		//a cell can be both in content and format, collect each only once
+		GridSet Coords;
+		for (const GridSet* aSet : { &m_Content, &m_Format })
 		{
-			std::vector<Cell> InitCells;
-
-			for (const auto& Coord : aSet)
+			for (const auto& Coord : *aSet)
 			{
 				if (Coord.GetCol() >= PosColStart && Coord.GetCol() < PosColStart + NCols)
-					InitCells.push_back(GetAsCellObject(Coord));
+					Coords.insert(Coord);
 			}
+		}
 
-			evt->SetInitialCells(InitCells);
-		};
+		std::vector<Cell> InitCells;
+		InitCells.reserve(Coords.size());
+		for (const auto& Coord : Coords)
+			InitCells.push_back(GetAsCellObject(Coord));
 
-		CheckSet(m_Content);
-		CheckSet(m_Format);
+		evt->SetInitialCells(std::move(InitCells));
 
 		//Deletion 
 		DeleteCols(PosColStart, NCols, true);
@@ -419,6 +446,9 @@ namespace grid
 
 		m_Content.insert(wxGridCellCoords{ row, col });
 
+		if (m_ValueIndex)
+			m_ValueIndex->Update({ row, col }, event.GetString(), GetCellValue(row, col));
+
 		MarkDirty();
 
 		//Undo redo
@@ -527,18 +557,29 @@ namespace grid
 	}
 
 
-	void CWorksheetBase::Paste()
+	void CWorksheetBase::Paste(bool Transpose)
 	{
 		if (!wxTheClipboard->Open())
 			return;
 
 		std::pair<wxGridCellCoords, wxGridCellCoords> Coords;
+		std::vector<Cell> Overwritten;
+		PASTE PasteWhat = PASTE::ALL;
+		bool IsText = false;
 
-		if (wxTheClipboard->IsSupported(XMLDataFormat()))
-			Coords = Paste_XMLDataFormat(PASTE::ALL);
+		//binary format is compact and much faster to parse than XML
+		if (wxTheClipboard->IsSupported(BinaryDataFormat()))
+			Coords = Paste_BinaryDataFormat(PASTE::ALL, Transpose, &Overwritten);
+
+		else if (wxTheClipboard->IsSupported(XMLDataFormat()))
+			Coords = Paste_XMLDataFormat(PASTE::ALL, Transpose, &Overwritten);
 
 		else if (wxTheClipboard->IsSupported(wxDF_TEXT))
-			Coords = Paste_TextValues();
+		{
+			Coords = Paste_TextValues(Transpose, &Overwritten);
+			PasteWhat = PASTE::VALUES;
+			IsText = true;
+		}
 
 		wxTheClipboard->Close();
 
@@ -556,14 +597,83 @@ namespace grid
 		MarkDirty();
 
 		auto dp_evt = std::make_unique<DataPasted>(this);
-		dp_evt->SetPaste((int)PASTE::ALL);
+		dp_evt->SetPaste((int)PasteWhat);
 		dp_evt->SetCoords(Coords);
+		dp_evt->SetInitialCells(std::move(Overwritten));
+		dp_evt->SetFinalCells(GetPopulatedCells(Coords.first, Coords.second));
+		dp_evt->SetInferTypes(IsText);
 
 		if(m_WBase)
 			m_WBase->PushUndoEvent(std::move(dp_evt));
 	}
 
 
+	void CWorksheetBase::PasteFill()
+	{
+		if (!IsSelection())
+		{
+			Paste();
+			return;
+		}
+
+		wxGridCellCoords TL = GetSelTopLeft(), BR = GetSelBtmRight();
+
+		PASTE PasteWhat = PASTE::ALL;
+		std::vector<Cell> Source;
+
+		if (SupportsBinary())
+			Source = GetBinaryData();
+
+		else if (SupportsXML())
+		{
+			if (auto xmlDoc = CreateXMLDoc(GetXMLData()))
+				Source = XMLDocToCells(this, xmlDoc.value());
+		}
+		else
+		{
+			//plain text carries no format
+			Source = TabStringToCells(GetTextData());
+			PasteWhat = PASTE::VALUES;
+		}
+
+		if (Source.empty())
+			return;
+
+		std::vector<Cell> Overwritten;
+		TileBlock(Source, TL, BR, PasteWhat, &Overwritten);
+
+		//only the source block, the rectangle and the overwritten cells are kept, not every filled cell
+		auto evt = std::make_unique<DataPasteFilled>(this);
+		evt->SetPaste((int)PasteWhat);
+		evt->SetSource(std::move(Source));
+		evt->SetInitialCells(std::move(Overwritten));
+		evt->SetCoords(TL, BR);
+
+		if (m_WBase)
+			m_WBase->PushUndoEvent(std::move(evt));
+	}
+
+
+	void CWorksheetBase::Fill(const FillGenerator& Gen)
+	{
+		if (!IsSelection())
+			return;
+
+		wxGridCellCoords TL = GetSelTopLeft(), BR = GetSelBtmRight();
+
+		std::vector<Cell> Overwritten;
+		if (!FillBlock(TL, BR, Gen, &Overwritten))
+			return;
+
+		//generator and rectangle are enough to redo
+		auto evt = std::make_unique<DataFilled>(this, TL, BR, Gen);
+		evt->SetInitialCells(std::move(Overwritten));
+
+		if (m_WBase)
+			m_WBase->PushUndoEvent(std::move(evt));
+	}
+
+
 	void CWorksheetBase::OnKeyDown(wxKeyEvent& event)
 	{
 		int KC = event.GetKeyCode();
@@ -602,6 +712,12 @@ namespace grid
 		const wxString& value,
 		bool MakeDirty)
 	{
+		if (m_WBase && m_WBase->IsInTransaction())
+			m_WBase->RecordValueChange(this, row, col, wxGrid::GetCellValue(row, col), value);
+
+		if (m_ValueIndex)
+			m_ValueIndex->Update({ row, col }, wxGrid::GetCellValue(row, col), value);
+
 		wxGrid::SetCellValue(row, col, value);
 
 		if (value.IsEmpty())
@@ -617,6 +733,13 @@ namespace grid
 	void CWorksheetBase::SetValue(int row, int col, const wxString& value, bool MakeDirty)
 	{
 		auto Table = GetTable();
+
+		if (m_WBase && m_WBase->IsInTransaction())
+			m_WBase->RecordValueChange(this, row, col, Table->GetValue(row, col), value);
+
+		if (m_ValueIndex)
+			m_ValueIndex->Update({ row, col }, Table->GetValue(row, col), value);
+
 		Table->SetValue(row, col, value);
 
 		if (value.IsEmpty())
@@ -693,6 +816,99 @@ namespace grid
 	}
 
 
+	void CWorksheetBase::EnableValueIndex(bool Enable)
+	{
+		if (!Enable)
+		{
+			m_ValueIndex.reset();
+			return;
+		}
+
+		if (m_ValueIndex)
+			return;
+
+		m_ValueIndex = std::make_unique<CValueIndex>();
+
+		auto Table = GetTable();
+		for (const auto& Coord : m_Content)
+			m_ValueIndex->Add(Table->GetValue(Coord.GetRow(), Coord.GetCol()), Coord);
+	}
+
+
+	void CWorksheetBase::InferColTypes(int FirstCol, int LastCol)
+	{
+		if (FirstCol > LastCol)
+			return;
+
+		std::vector<NarrowCells> Columns(LastCol - FirstCol + 1);
+
+		if (!m_Content.empty())
+		{
+			auto Table = GetTable();
+
+			//content is ordered by row then column, columns outside the range are skipped
+			auto it = m_Content.lower_bound({ m_Content.begin()->GetRow(), FirstCol });
+			while (it != m_Content.end())
+			{
+				int Row = it->GetRow(), Col = it->GetCol();
+
+				if (Col < FirstCol)
+				{
+					it = m_Content.lower_bound({ Row, FirstCol });
+					continue;
+				}
+
+				if (Col > LastCol)
+				{
+					it = m_Content.lower_bound({ Row + 1, FirstCol });
+					continue;
+				}
+
+				Columns[Col - FirstCol].Append(Table->GetValue(Row, Col));
+				++it;
+			}
+		}
+
+		int Horiz{}, Vert{};
+		GetDefaultCellAlignment(&Horiz, &Vert);
+
+		for (size_t j = 0; j < Columns.size(); ++j)
+		{
+			int Col = FirstCol + (int)j;
+
+			Columns[j].Close();
+			auto Type = InferType(Columns[j]);
+
+			if (Type == CELLTYPE::EMPTY)
+				m_ColTypes.erase(Col);
+			else
+				m_ColTypes[Col] = Type;
+
+			if (Type == CELLTYPE::INTEGER || Type == CELLTYPE::FLOAT || Type == CELLTYPE::DATE)
+			{
+				auto Attr = new wxGridCellAttr();
+				Attr->SetAlignment(wxALIGN_RIGHT, Vert);
+				SetColAttr(Col, Attr);
+			}
+			else
+				SetColAttr(Col, nullptr);
+		}
+	}
+
+
+	CELLTYPE CWorksheetBase::GetColType(int Col) const
+	{
+		auto it = m_ColTypes.find(Col);
+		return it != m_ColTypes.end() ? it->second : CELLTYPE::EMPTY;
+	}
+
+
+	const SelStats& CWorksheetBase::GetSelectionStats() const
+	{
+		return m_SelStats->GetStats();
+	}
+
+
 	wxGridCellCoords CWorksheetBase::GetSelTopLeft() const
 	{
 		if (IsSelection())
@@ -772,6 +988,136 @@ namespace grid
 	}
 
 
+	void CWorksheetBase::PermuteRows(
+		const wxGridCellCoords& TL,
+		const wxGridCellCoords& BR,
+		const std::vector<int>& Perm)
+	{
+		int Row0 = TL.GetRow(), Left = TL.GetCol(), Right = BR.GetCol();
+		int NRows = (int)Perm.size();
+
+		assert(NRows == BR.GetRow() - Row0 + 1);
+
+		//cells of the moving rows in row-major order, Begin[k] is the first cell of row Row0 + k
+		struct Moving
+		{
+			std::vector<wxGridCellCoords> m_Coords;
+			std::vector<size_t> m_Begin;
+		};
+
+		//takes the cells of the moving rows out of Set
+		auto Take = [&](GridSet& Set)
+		{
+			Moving Cells;
+			Cells.m_Begin.assign((size_t)NRows + 1, 0);
+
+			auto it = Set.lower_bound(TL);
+			while (it != Set.end() && it->GetRow() <= BR.GetRow())
+			{
+				int Row = it->GetRow(), Col = it->GetCol();
+
+				if (Col < Left) {
+					it = Set.lower_bound({ Row, Left });
+					continue;
+				}
+
+				if (Col > Right || Perm[Row - Row0] == Row - Row0) {
+					it = Set.lower_bound({ Row + 1, Left });
+					continue;
+				}
+
+				Cells.m_Coords.push_back(*it);
+				Cells.m_Begin[Row - Row0 + 1]++;
+
+				it = Set.erase(it);
+			}
+
+			for (int k = 0; k < NRows; ++k)
+				Cells.m_Begin[k + 1] += Cells.m_Begin[k];
+
+			return Cells;
+		};
+
+		//Put(n, Dest) moves the n-th taken cell to Dest
+		auto Place = [&](GridSet& Set, const Moving& Cells, auto&& Put)
+		{
+			auto Hint = Set.lower_bound(TL);
+
+			for (int i = 0; i < NRows; ++i)
+			{
+				int k = Perm[i];
+				if (k == i)
+					continue;
+
+				for (size_t n = Cells.m_Begin[k]; n < Cells.m_Begin[k + 1]; ++n)
+				{
+					wxGridCellCoords Dest(Row0 + i, Cells.m_Coords[n].GetCol());
+					Put(n, Dest);
+
+					//destinations are increasing, the hint is mostly exact
+					Hint = std::next(Set.insert(Hint, Dest));
+				}
+			}
+		};
+
+		auto Table = GetTable();
+
+		BeginBatch();
+
+		//values and attributes are read before any row is overwritten
+		auto Contents = Take(m_Content);
+
+		std::vector<wxString> Values;
+		Values.reserve(Contents.m_Coords.size());
+		for (const auto& Coord : Contents.m_Coords)
+		{
+			Values.push_back(Table->GetValue(Coord.GetRow(), Coord.GetCol()));
+			Table->SetValue(Coord.GetRow(), Coord.GetCol(), wxEmptyString);
+
+			if (m_ValueIndex)
+				m_ValueIndex->Remove(Values.back(), Coord);
+		}
+
+		auto Formats = Take(m_Format);
+
+		//attributes are moved, not copied (GetAttr increments the reference count)
+		std::vector<wxGridCellAttr*> Attrs;
+		Attrs.reserve(Formats.m_Coords.size());
+		for (const auto& Coord : Formats.m_Coords)
+		{
+			Attrs.push_back(Table->GetAttr(Coord.GetRow(), Coord.GetCol(), wxGridCellAttr::Cell));
+			Table->SetAttr(nullptr, Coord.GetRow(), Coord.GetCol());
+		}
+
+		Place(m_Content, Contents, [&](size_t n, const wxGridCellCoords& Dest)
+		{
+			Table->SetValue(Dest.GetRow(), Dest.GetCol(), Values[n]);
+
+			if (m_ValueIndex)
+				m_ValueIndex->Add(Values[n], Dest);
+		});
+
+		Place(m_Format, Formats, [&](size_t n, const wxGridCellCoords& Dest)
+		{
+			Table->SetAttr(Attrs[n], Dest.GetRow(), Dest.GetCol());
+		});
+
+		//fonts moved with the cells
+		if (!Formats.m_Coords.empty())
+		{
+			for (int i = 0; i < NRows; ++i)
+			{
+				if (Perm[i] != i)
+					AdjustRowHeight(Row0 + i, false);
+			}
+		}
+
+		EndBatch();
+
+		MarkDirty();
+	}
+
+
 	void CWorksheetBase::ApplyCellFormat(int row, int column, const Cell& cell, bool MakeDirty)
 	{
 		auto Format = cell.GetFormat();
@@ -818,7 +1164,7 @@ namespace grid
 	}
 
 
-	void CWorksheetBase::AdjustRowHeight(int CurRow)
+	void CWorksheetBase::AdjustRowHeight(int CurRow, bool MakeDirty)
 	{
 		int Height = GetDefaultRowSize();
 
@@ -832,24 +1178,24 @@ namespace grid
 		}
 
 		//Check the columns in the particular row (CurRow) with changed format
-		for (const auto& Coord : m_Format)
+		//sets are inherently ordered and in this case it is ordered by row, so jump to the first column of CurRow
+		for (auto it = m_Format.lower_bound(wxGridCellCoords(CurRow, 0)); it != m_Format.end(); ++it)
 		{
-			//sets are inherently ordered and in this case it is ordered by row
-			if (Coord.GetRow() > CurRow)
+			if (it->GetRow() > CurRow)
 				break;
 
-			if (Coord.GetRow() < CurRow)
-				continue;
-
 			//required height
-			int ReqRow_H = FromDIP(GetCellFont(Coord.GetRow(), Coord.GetCol()).GetPixelSize().GetHeight());
+			int ReqRow_H = FromDIP(GetCellFont(it->GetRow(), it->GetCol()).GetPixelSize().GetHeight());
 
 			if (ReqRow_H > Height)
 				Height = ReqRow_H;
 		}
 
 		//Here the MinimumRowHeight is the row height that will accomodate the font with the largest point size
-		SetRowSize(CurRow, Height);
+		if (MakeDirty)
+			SetRowSize(CurRow, Height);
+		else
+			SetCleanRowSize(CurRow, Height);
 
 		m_AdjustedRows[CurRow] = Row(Height);
 	}
@@ -888,6 +1234,282 @@ namespace grid
 	}
 
 
+	std::vector<Cell> CWorksheetBase::GetPopulatedCells(
+		const wxGridCellCoords& TL, 
+		const wxGridCellCoords& BR) const
+	{
+		//a cell can be both in content and format
+		GridSet Coords;
+		for (const GridSet* aSet : { &m_Content, &m_Format })
+		{
+			auto it = aSet->lower_bound(TL);
+			for (; it != aSet->end() && it->GetRow() <= BR.GetRow(); ++it)
+			{
+				if (it->GetCol() >= TL.GetCol() && it->GetCol() <= BR.GetCol())
+					Coords.insert(*it);
+			}
+		}
+
+		std::vector<Cell> Cells;
+		Cells.reserve(Coords.size());
+		for (const auto& Coord : Coords)
+			Cells.push_back(GetAsCellObject(Coord));
+
+		return Cells;
+	}
+
+
+	void CWorksheetBase::SetBlock(
+		const std::vector<Cell>& Cells, 
+		PASTE PasteWhat)
+	{
+		if (Cells.empty())
+			return;
+
+		BeginBatch();
+
+		std::set<int> Rows;
+		for (const auto& cell : Cells)
+		{
+			WriteCell(cell.GetRow(), cell.GetCol(), cell, PasteWhat);
+			Rows.insert(cell.GetRow());
+		}
+
+		if (PasteWhat == PASTE::ALL || PasteWhat == PASTE::FORMAT)
+		{
+			for (int row : Rows)
+				AdjustRowHeight(row, false);
+		}
+
+		EndBatch();
+
+		MarkDirty();
+	}
+
+
+	void CWorksheetBase::ClearPopulatedCells(
+		const wxGridCellCoords& TL, 
+		const wxGridCellCoords& BR, 
+		PASTE PasteWhat)
+	{
+		//clearing erases from the sets, therefore collect first
+		auto Collect = [&](const GridSet& aSet)
+		{
+			std::vector<wxGridCellCoords> Coords;
+			
+			auto it = aSet.lower_bound(TL);
+			for (; it != aSet.end() && it->GetRow() <= BR.GetRow(); ++it)
+			{
+				if (it->GetCol() >= TL.GetCol() && it->GetCol() <= BR.GetCol())
+					Coords.push_back(*it);
+			}
+
+			return Coords;
+		};
+
+		bool Values = PasteWhat == PASTE::ALL || PasteWhat == PASTE::VALUES;
+		bool Formats = PasteWhat == PASTE::ALL || PasteWhat == PASTE::FORMAT;
+
+		auto ContentCoords = Values ? Collect(m_Content) : std::vector<wxGridCellCoords>();
+		auto FormatCoords = Formats ? Collect(m_Format) : std::vector<wxGridCellCoords>();
+
+		if (ContentCoords.empty() && FormatCoords.empty())
+			return;
+
+		BeginBatch();
+
+		std::set<int> Rows;
+		for (const auto& Coord : ContentCoords)
+		{
+			SetValue(Coord.GetRow(), Coord.GetCol(), wxEmptyString, false);
+			Rows.insert(Coord.GetRow());
+		}
+
+		for (const auto& Coord : FormatCoords)
+		{
+			ResetCellFormat(Coord.GetRow(), Coord.GetCol());
+			Rows.insert(Coord.GetRow());
+		}
+
+		for (int row : Rows)
+			AdjustRowHeight(row, false);
+
+		EndBatch();
+
+		MarkDirty();
+	}
+
+
+	void CWorksheetBase::ResetCellFormat(int row, int col)
+	{
+		wxGrid::SetCellBackgroundColour(row, col, GetDefaultCellBackgroundColour());
+		wxGrid::SetCellTextColour(row, col, GetDefaultCellTextColour());
+		wxGrid::SetCellFont(row, col, GetDefaultCellFont());
+
+		int horizontal = 0, vertical = 0;
+		GetDefaultCellAlignment(&horizontal, &vertical);
+		wxGrid::SetCellAlignment(row, col, horizontal, vertical);
+
+		m_Format.erase({ row, col });
+	}
+
+
+	void CWorksheetBase::TileBlock(
+		const std::vector<Cell>& Source,
+		const wxGridCellCoords& TL,
+		const wxGridCellCoords& BR,
+		PASTE PasteWhat,
+		std::vector<Cell>* Overwritten)
+	{
+		if (Source.empty())
+			return;
+
+		auto SrcCorners = Cell::Get_TLBR(Source);
+		int SrcRow = SrcCorners.first.GetRow(), SrcCol = SrcCorners.first.GetCol();
+
+		int NSrcRows = SrcCorners.second.GetRow() - SrcRow + 1;
+		int NSrcCols = SrcCorners.second.GetCol() - SrcCol + 1;
+
+		//never write outside of the grid
+		int LastRow = std::min(BR.GetRow(), GetNumberRows() - 1);
+		int LastCol = std::min(BR.GetCol(), GetNumberCols() - 1);
+
+		if (Overwritten)
+			*Overwritten = GetPopulatedCells(TL, wxGridCellCoords(LastRow, LastCol));
+
+		BeginBatch();
+
+		for (int TileRow = TL.GetRow(); TileRow <= LastRow; TileRow += NSrcRows)
+		{
+			for (int TileCol = TL.GetCol(); TileCol <= LastCol; TileCol += NSrcCols)
+			{
+				for (const auto& cell : Source)
+				{
+					int row = TileRow + cell.GetRow() - SrcRow;
+					int col = TileCol + cell.GetCol() - SrcCol;
+
+					if (row > LastRow || col > LastCol)
+						continue;
+
+					WriteCell(row, col, cell, PasteWhat);
+				}
+			}
+		}
+
+		if (PasteWhat == PASTE::ALL || PasteWhat == PASTE::FORMAT)
+		{
+			for (int row = TL.GetRow(); row <= LastRow; ++row)
+				AdjustRowHeight(row, false);
+		}
+
+		EndBatch();
+
+		MarkDirty();
+	}
+
+
+	bool CWorksheetBase::FillBlock(
+		const wxGridCellCoords& TL,
+		const wxGridCellCoords& BR,
+		const FillGenerator& Gen,
+		std::vector<Cell>* Overwritten)
+	{
+		int LastRow = std::min(BR.GetRow(), GetNumberRows() - 1);
+		int LastCol = std::min(BR.GetCol(), GetNumberCols() - 1);
+
+		bool Down = Gen.IsDown();
+
+		//the first row (or column) is the source
+		wxGridCellCoords DestTL = Down ?
+			wxGridCellCoords(TL.GetRow() + 1, TL.GetCol()) :
+			wxGridCellCoords(TL.GetRow(), TL.GetCol() + 1);
+
+		if (DestTL.GetRow() > LastRow || DestTL.GetCol() > LastCol)
+			return false;
+
+		wxGridCellCoords DestBR(LastRow, LastCol);
+
+		if (Overwritten)
+			*Overwritten = GetPopulatedCells(DestTL, DestBR);
+
+		if (!Gen.IsSeries())
+		{
+			//empty source cells are included so that they clear the cells they are copied over
+			std::vector<Cell> Source;
+			if (Down)
+			{
+				for (int col = TL.GetCol(); col <= LastCol; ++col)
+					Source.push_back(GetAsCellObject(TL.GetRow(), col));
+			}
+			else
+			{
+				for (int row = TL.GetRow(); row <= LastRow; ++row)
+					Source.push_back(GetAsCellObject(row, TL.GetCol()));
+			}
+
+			TileBlock(Source, DestTL, DestBR, PASTE::ALL);
+
+			return true;
+		}
+
+		auto Table = GetTable();
+
+		int NLines = Down ? LastCol - TL.GetCol() + 1 : LastRow - TL.GetRow() + 1;
+		int Length = Down ? LastRow - DestTL.GetRow() + 1 : LastCol - DestTL.GetCol() + 1;
+
+		auto DestCoord = [&](int Line, int i)
+		{
+			return Down ?
+				wxGridCellCoords(DestTL.GetRow() + i, DestTL.GetCol() + Line) :
+				wxGridCellCoords(DestTL.GetRow() + Line, DestTL.GetCol() + i);
+		};
+
+		bool Written = false;
+
+		BeginBatch();
+
+		std::vector<wxString> Values(Length);
+		for (int Line = 0; Line < NLines; ++Line)
+		{
+			wxGridCellCoords Start = Down ?
+				wxGridCellCoords(TL.GetRow(), TL.GetCol() + Line) :
+				wxGridCellCoords(TL.GetRow() + Line, TL.GetCol());
+
+			if (!GenerateSeries(Table->GetValue(Start.GetRow(), Start.GetCol()), Gen, Values))
+				continue;
+
+			for (int i = 0; i < Length; ++i)
+			{
+				auto Coord = DestCoord(Line, i);
+				SetValue(Coord.GetRow(), Coord.GetCol(), Values[i], false);
+			}
+
+			Written = true;
+		}
+
+		EndBatch();
+
+		if (Written)
+			MarkDirty();
+
+		return Written;
+	}
+
+
+	void CWorksheetBase::WriteCell(
+		int row,
+		int col,
+		const Cell& cell,
+		PASTE PasteWhat)
+	{
+		if (PasteWhat == PASTE::ALL || PasteWhat == PASTE::VALUES)
+			SetValue(row, col, cell.GetValue(), false);
+
+		if (PasteWhat == PASTE::ALL || PasteWhat == PASTE::FORMAT)
+			ApplyCellFormat(row, col, cell, false);
+	}
+
+
 	void CWorksheetBase::SetBlockBackgroundColor(
 		const wxGridCellCoords TL,
 		const wxGridCellCoords BR,
@@ -1174,6 +1796,9 @@ namespace grid
 		Update(m_Content);
 		Update(m_Format);
 
+		if (m_ValueIndex)
+			m_ValueIndex->ShiftRows(pos, -numRows);
+
 		MarkDirty();
 
 		return true;
@@ -1208,6 +1833,9 @@ namespace grid
 		UpdateSet(m_Content);
 		UpdateSet(m_Format);
 
+		if (m_ValueIndex)
+			m_ValueIndex->ShiftRows(pos, numRows);
+
 		MarkDirty();
 
 		return true;
@@ -1242,6 +1870,19 @@ namespace grid
 		Update(m_Content);
 		Update(m_Format);
 
+		if (m_ValueIndex)
+			m_ValueIndex->ShiftCols(pos, -numCols);
+
+		std::map<int, CELLTYPE> ColTypes;
+		for (const auto& [Col, Type] : m_ColTypes)
+		{
+			if (Col < pos)
+				ColTypes[Col] = Type;
+			else if (Col >= pos + numCols)
+				ColTypes[Col - numCols] = Type;
+		}
+		m_ColTypes = std::move(ColTypes);
+
 		MarkDirty();
 
 		return true;
@@ -1275,6 +1916,14 @@ namespace grid
 		UpdateSet(m_Content);
 		UpdateSet(m_Format);
 
+		if (m_ValueIndex)
+			m_ValueIndex->ShiftCols(pos, numCols);
+
+		std::map<int, CELLTYPE> ColTypes;
+		for (const auto& [Col, Type] : m_ColTypes)
+			ColTypes[Col < pos ? Col : Col + numCols] = Type;
+		m_ColTypes = std::move(ColTypes);
+
 		MarkDirty();
 
 		return true;
@@ -1286,6 +1935,11 @@ namespace grid
 	void CWorksheetBase::MarkDirty()
 	{
 		m_IsDirty = true;
+		m_SelStats->Invalidate();
+
+		//collected by the workbook, notified once when resumed
+		if (m_WBase && m_WBase->DeferDirty(this))
+			return;
 		
 		wxCommandEvent evt(ssEVT_WS_DIRTY, GetId());
 		evt.SetEventObject(this);
@@ -1377,7 +2031,12 @@ namespace grid
 
 		wxXmlDocument xmlDoc(iss);
 
-		return ParseXMLDoc(this, xmlDoc);
+		if (!ParseXMLDoc(this, xmlDoc))
+			return false;
+
+		InferColTypes(0, GetNumberCols() - 1);
+
+		return true;
 	}
 
 
@@ -1396,26 +2055,55 @@ namespace grid
 		wxStringInputStream iss(XML);
 		wxXmlDocument xmlDoc(iss);
 
-		return ParseXMLDoc(this, xmlDoc);
+		if (!ParseXMLDoc(this, xmlDoc))
+			return false;
+
+		InferColTypes(0, GetNumberCols() - 1);
+
+		return true;
 	}
 
 
-	std::pair<wxGridCellCoords, wxGridCellCoords> CWorksheetBase::Paste_XMLDataFormat(PASTE PasteWhat)
+	std::pair<wxGridCellCoords, wxGridCellCoords> CWorksheetBase::Paste_XMLDataFormat(
+		PASTE PasteWhat, 
+		bool Transpose,
+		std::vector<Cell>* Overwritten)
 	{
-		//This is where the user currently placed the cursor on Worksheet and pasting the data as of
-		int RowPos = GetGridCursorRow();
-		int ColPos = GetGridCursorCol();
-
 		wxString XMLStr = GetXMLData();
 		assert(!XMLStr.IsEmpty());
 
 		auto xmlDoc = CreateXMLDoc(XMLStr);
 		assert(xmlDoc.has_value() && xmlDoc.value().IsOk());
 
-		auto cellVec = XMLDocToCells(this, xmlDoc.value());
+		return PasteCells(XMLDocToCells(this, xmlDoc.value()), PasteWhat, Transpose, Overwritten);
+	}
+
+
+	std::pair<wxGridCellCoords, wxGridCellCoords> CWorksheetBase::Paste_BinaryDataFormat(
+		PASTE PasteWhat,
+		bool Transpose,
+		std::vector<Cell>* Overwritten)
+	{
+		return PasteCells(GetBinaryData(), PasteWhat, Transpose, Overwritten);
+	}
+
+
+	std::pair<wxGridCellCoords, wxGridCellCoords> CWorksheetBase::PasteCells(
+		std::vector<Cell> cellVec,
+		PASTE PasteWhat,
+		bool Transpose,
+		std::vector<Cell>* Overwritten)
+	{
+		//This is where the user currently placed the cursor on Worksheet and pasting the data as of
+		int RowPos = GetGridCursorRow();
+		int ColPos = GetGridCursorCol();
+
 		if (cellVec.size() == 0)
 			return { wxGridCellCoords(), wxGridCellCoords() };
 
+		if (Transpose)
+			cellVec = TransposeCells(std::move(cellVec));
+
 		//This is the area where the data is coming from
 		auto Corners = Cell::Get_TLBR(cellVec);
 
@@ -1423,80 +2111,47 @@ namespace grid
 		int diffRow = RowPos - Corners.first.GetRow(); //first: topleft
 		int diffCol = ColPos - Corners.first.GetCol();
 
-		for (const auto& cell : cellVec) {
-			int row = cell.GetRow(), col = cell.GetCol();
-
-			if (PasteWhat == PASTE::ALL || PasteWhat == PASTE::VALUES)
-				SetCellValue(row + diffRow, col + diffCol, cell.GetValue());
-
-			if (PasteWhat == PASTE::ALL || PasteWhat == PASTE::FORMAT) {
-				ApplyCellFormat(row + diffRow, col + diffCol, cell);
-				AdjustRowHeight(row + diffRow);
-			}
-		}
-
-		MarkDirty();
-
 		//This is the area where the data is pasted
 		wxGridCellCoords TL(RowPos, ColPos);
 		wxGridCellCoords BR(
 			Corners.second.GetRow() + diffRow,
 			Corners.second.GetCol() + diffCol);
 
+		//a single tile
+		TileBlock(cellVec, TL, BR, PasteWhat, Overwritten);
+
 		return { TL, BR };
 	}
 
 
-	std::pair<wxGridCellCoords, wxGridCellCoords> CWorksheetBase::Paste_TextValues()
+	std::pair<wxGridCellCoords, wxGridCellCoords> CWorksheetBase::Paste_TextValues(
+		bool Transpose,
+		std::vector<Cell>* Overwritten)
 	{
 		//This is where the user currently placed the cursor on Worksheet and pasting the data as of
 		int RowPos = GetGridCursorRow();
 		int ColPos = GetGridCursorCol();
 
-		//Number of columns in the data
-		int NCols = 0;
-
-		//If the data consists of rows with unequal number of columns
-		int MaxNCols = NCols;
-
-		wxGridCellCoords TopLeft(RowPos, ColPos);
-
-		if (!wxTheClipboard->IsSupported(wxDF_TEXT) || !wxTheClipboard->Open())
-			return{ wxGridCellCoords(), wxGridCellCoords() };
-
-		wxTextDataObject data;
-		wxTheClipboard->GetData(data);
-		wxTheClipboard->Close();
-
-		wxString str = data.GetText();
+		wxString str = GetTextData();
 		if (str.empty())
 			return { wxGridCellCoords(), wxGridCellCoords() };
 
+		auto cellVec = TabStringToCells(str, RowPos, ColPos);
+		if (cellVec.empty())
+			return { wxGridCellCoords(), wxGridCellCoords() };
 
-		wxStringTokenizer lines(str, "\n", wxTOKEN_RET_EMPTY);
-		while (lines.HasMoreTokens())
-		{
-			wxStringTokenizer columns(lines.GetNextToken(), '\t', wxTOKEN_RET_EMPTY);
-
-			int colvalue = ColPos;
-
-			while (columns.HasMoreTokens())
-				SetCellValue(RowPos, colvalue++, columns.GetNextToken());
-
-			RowPos++;
-
-			NCols = (colvalue - 1) - ColPos + 1;
+		if (Transpose)
+			cellVec = TransposeCells(std::move(cellVec));
 
-			if (NCols > MaxNCols)
-				MaxNCols = NCols;
-		}
+		//If the data consists of rows with unequal number of columns, BR covers the longest row
+		auto Corners = Cell::Get_TLBR(cellVec);
+		wxGridCellCoords TopLeft(RowPos, ColPos);
 
-		MarkDirty();
+		TileBlock(cellVec, TopLeft, Corners.second, PASTE::VALUES, Overwritten);
 
-		//Note that RosPos is changing in the loop
-		wxGridCellCoords BottomRight(RowPos - 1, ColPos + MaxNCols - 1); //NCols=EndPos-ColPos+1;
+		InferColTypes(TopLeft.GetCol(), Corners.second.GetCol());
 
-		return { TopLeft, BottomRight };
+		return { TopLeft, Corners.second };
 	}
 
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <memory>
 #include <list>
 #include <map>
 #include <set>
@@ -13,6 +14,8 @@
 #include <wx/wfstream.h>
 #include <wx/zipstrm.h>
 
+#include "celltype.h"
+#include "fill.h"
 #include "dllimpexp.h"
 
 
@@ -27,6 +30,9 @@ namespace grid
 	class Cell;
 	class CWorkbookBase;
 	class CSelRect;
+	class CSelectionStats;
+	class CValueIndex;
+	struct SelStats;
 
 	class DLLGRID CWorksheetBase :public wxGrid
 	{
@@ -80,21 +86,52 @@ namespace grid
 			return m_WBase;
 		}
 
+		//unique during the lifetime of the application, never reused
+		size_t GetWSId() const {
+			return m_Id;
+		}
+
 		bool ReadXMLDoc(wxZipInputStream& InStream, wxZipEntry* Entry);
 
 		//Read from snapshot directory, WorksheetFullPath is in snapshot directory 
 		bool ReadXMLDoc(const std::filesystem::path& WSPath);
 
-		// Return the TL and BR coordinates where the data is pasted
-		std::pair<wxGridCellCoords, wxGridCellCoords> Paste_XMLDataFormat(PASTE paste = PASTE::ALL);
+		/*
+			Pasting functions return the TL and BR coordinates where the data is pasted (rows become columns if Transpose).
+			If Overwritten is not null, it receives the populated cells of the area before they are overwritten.
+		*/
+		std::pair<wxGridCellCoords, wxGridCellCoords> Paste_XMLDataFormat(
+			PASTE paste = PASTE::ALL, 
+			bool Transpose = false,
+			std::vector<Cell>* Overwritten = nullptr);
 
-		//Return the TL and BR coordinates where the data is pasted
-		std::pair<wxGridCellCoords, wxGridCellCoords> Paste_TextValues();
+		std::pair<wxGridCellCoords, wxGridCellCoords> Paste_BinaryDataFormat(
+			PASTE paste = PASTE::ALL, 
+			bool Transpose = false,
+			std::vector<Cell>* Overwritten = nullptr);
+
+		std::pair<wxGridCellCoords, wxGridCellCoords> Paste_TextValues(
+			bool Transpose = false,
+			std::vector<Cell>* Overwritten = nullptr);
 
 
 		void Cut();
 		void Delete();
-		void Paste();
+		void Paste(bool Transpose = false);
+
+		//Tiles the clipboard block over the selected rectangle (if no selection same as Paste)
+		void PasteFill();
+
+		//fill the selected rectangle from its first row, first column or as a series (see FillGenerator)
+		void Fill(const FillGenerator& Gen);
+
+		void FillDown() {
+			Fill({ FILL::DOWN });
+		}
+
+		void FillRight() {
+			Fill({ FILL::RIGHT });
+		}
 
 
 		//Tells process event to block some of the events (see ProcessGridSelectionEvent)
@@ -108,11 +145,11 @@ namespace grid
 		}
 
 
-		auto GetChangedCells_Format() const {
+		const auto& GetChangedCells_Format() const {
 			return  m_Format;
 		}
 
-		auto GetChangedCells_Content() const {
+		const auto& GetChangedCells_Content() const {
 			return m_Content;
 		}
 
@@ -206,6 +243,31 @@ namespace grid
 		size_t GetNumSelCols() const;
 		size_t GetNumSelRows() const;
 
+		//stats of the selected block, updated as the selection changes (see ssEVT_WS_SELSTATS)
+		const SelStats& GetSelectionStats() const;
+
+		/*
+			Index from values to cells, used by CRangeBase::find and replace.
+			Built from the current content when enabled and then kept up to date by every edit.
+		*/
+		void EnableValueIndex(bool Enable = true);
+
+		//nullptr if not enabled
+		const CValueIndex* GetValueIndex() const {
+			return m_ValueIndex.get();
+		}
+
+
+		/*
+			Infers the type of columns [FirstCol, LastCol] from their populated cells (see InferType).
+			Integer, float and date columns are right-aligned unless a cell sets its own alignment.
+			Called after text is pasted (and when that paste is undone or redone) and after the worksheet is loaded.
+		*/
+		void InferColTypes(int FirstCol, int LastCol);
+
+		//EMPTY if the column has no populated cells or its type has not been inferred
+		CELLTYPE GetColType(int Col) const;
+
 
 		bool ClearBlockContent(
 			const wxGridCellCoords& TL,
@@ -215,6 +277,15 @@ namespace grid
 			const wxGridCellCoords& TL,
 			const wxGridCellCoords& BR);
 
+		/*
+			Row TL + i of the block receives the values and formats of row TL + Perm[i].
+			Only the populated cells of the rows that move are touched. Does not record undo.
+		*/
+		void PermuteRows(
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			const std::vector<int>& Perm);
+
 
 		void SetCellFormattoDefault(
 			int row,
@@ -257,12 +328,52 @@ namespace grid
 			const wxGridCellCoords& BR,
 			int Alignment);
 
-		void AdjustRowHeight(int row);
+		void AdjustRowHeight(int row, bool MakeDirty = true);
 
 		std::vector<Cell> GetBlock(
 			const wxGridCellCoords& TL,
 			const wxGridCellCoords& BR) const;
 
+		//Only the cells with content or format within the block (cost depends on the number of such cells, not the area)
+		std::vector<Cell> GetPopulatedCells(
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR) const;
+
+		//Writes the cells at their own coordinates, marks the worksheet dirty only once
+		void SetBlock(
+			const std::vector<Cell>& Cells,
+			PASTE PasteWhat = PASTE::ALL);
+
+		//Clears content and/or format of the populated cells within the block
+		void ClearPopulatedCells(
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			PASTE PasteWhat = PASTE::ALL);
+
+
+		/*
+			Writes Source repeatedly over the rectangle TL:BR, source's topleft is the origin of each tile.
+			Tiles at the right and bottom edges are clipped. Marks the worksheet dirty only once.
+		*/
+		void TileBlock(
+			const std::vector<Cell>& Source,
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			PASTE PasteWhat = PASTE::ALL,
+			std::vector<Cell>* Overwritten = nullptr);
+
+		/*
+			Generates the rectangle TL:BR except its first row (or column) from it, cells outside of the grid are skipped.
+			DOWN and RIGHT copy values and formats, series only write values (a line whose first cell is not a number/date is left as is).
+			Values are written in bulk and the worksheet is marked dirty only once.
+			Returns false if nothing was written (no cells after the first row/column, or no line is a series).
+		*/
+		bool FillBlock(
+			const wxGridCellCoords& TL,
+			const wxGridCellCoords& BR,
+			const FillGenerator& Gen,
+			std::vector<Cell>* Overwritten = nullptr);
+
 
 		void DrawCellHighlight(wxDC& dc, const wxGridCellAttr* attr) override;
 
@@ -327,6 +438,23 @@ namespace grid
 		bool SelectionContainsColumn(int Col);
 		bool SelectionContainsRow(int Row);
 
+		//Pastes cells at grid cursor, returns TL and BR of the pasted area
+		std::pair<wxGridCellCoords, wxGridCellCoords> PasteCells(
+			std::vector<Cell> cellVec,
+			PASTE PasteWhat,
+			bool Transpose,
+			std::vector<Cell>* Overwritten);
+
+		//sets format to default without repainting or marking the worksheet dirty
+		void ResetCellFormat(int row, int col);
+
+		//writes value and/or format without marking the worksheet dirty (helper for bulk operations)
+		void WriteCell(
+			int row,
+			int col,
+			const Cell& cell,
+			PASTE PasteWhat);
+
 
 	protected:
 		bool m_IsDirty = false;
@@ -357,10 +485,18 @@ namespace grid
 		*/
 		wxGridCellCoords m_FocusIndicCell;
 
-		CWorkbookBase* m_WBase;
+		CWorkbookBase* m_WBase{ nullptr };
+
+		size_t m_Id;
 
 		CSelRect* m_RectData;
 
+		std::unique_ptr<CSelectionStats> m_SelStats;
+		std::unique_ptr<CValueIndex> m_ValueIndex;
+
+		//inferred types of the columns, values are still kept as text by the table
+		std::map<int, CELLTYPE> m_ColTypes;
+
 		//Selected Rectangle for GetGridColLabelWindow()
 		wxRect m_ColWndRect;
 		
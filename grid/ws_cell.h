@@ -104,7 +104,8 @@ namespace grid
 			m_Column = col;
 		}
 
-		std::wstring GetValue() const {
+		//by reference so that sizing and serializing cells does not copy values, valid while the Cell lives
+		const std::wstring& GetValue() const {
 			return m_Value;
 		}
 
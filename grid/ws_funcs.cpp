@@ -9,12 +9,17 @@
 #include <sstream>
 #include <codecvt>
 #include <locale>
+#include <unordered_map>
+#include <string_view>
+#include <cstring>
 
 #include <wx/wx.h>
 #include <wx/grid.h>
 #include <wx/clipbrd.h>
 #include <wx/tokenzr.h>
 #include <wx/sstream.h>
+#include <wx/mstream.h>
+#include <wx/zstream.h>
 
 
 #include "ws_cell.h"
@@ -22,6 +27,82 @@
 
 
 
+//Binary data helpers (see GenerateBinaryData)
+static void WriteVarint(std::string& Buf, uint64_t Val)
+{
+	while (Val >= 0x80)
+	{
+		Buf.push_back(char(Val | 0x80));
+		Val >>= 7;
+	}
+
+	Buf.push_back(char(Val));
+}
+
+
+static void WriteBytes(std::string& Buf, const char* Data, size_t Length)
+{
+	WriteVarint(Buf, Length);
+	Buf.append(Data, Length);
+}
+
+
+//0 is reserved for wxNullColour
+static uint64_t ColourToInt(const wxColour& Color)
+{
+	return Color.IsOk() ? (uint64_t)Color.GetRGBA() + 1 : 0;
+}
+
+
+struct BinaryReader
+{
+	const unsigned char* m_Pos;
+	const unsigned char* m_End;
+	bool m_OK{ true };
+
+	uint64_t Varint()
+	{
+		uint64_t Val = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (m_Pos >= m_End)
+				break;
+
+			unsigned char c = *m_Pos++;
+			Val |= uint64_t(c & 0x7F) << shift;
+
+			if ((c & 0x80) == 0)
+				return Val;
+		}
+
+		m_OK = false;
+		return 0;
+	}
+
+	std::string_view Bytes()
+	{
+		uint64_t Length = Varint();
+		if (!m_OK || Length > uint64_t(m_End - m_Pos))
+		{
+			m_OK = false;
+			return {};
+		}
+
+		std::string_view Str((const char*)m_Pos, Length);
+		m_Pos += Length;
+
+		return Str;
+	}
+};
+
+
+static const char BINARY_MAGIC[] = "SSB1";
+
+//upper bound of the uncompressed body accepted from the clipboard
+constexpr uint64_t MAX_BODYLENGTH = uint64_t(1) << 31;
+
+
+
 
 namespace grid
 {
@@ -187,17 +268,27 @@ namespace grid
 			BR = TL;
 		}
 
-		auto XMLStr = GenerateXMLString(ws, TL, BR);
-		wxString TabStr = GenerateTabString(ws, TL, BR);
+		//block is read once, binary and text are built from it, XML only when requested
+		auto Block = std::make_shared<const std::vector<Cell>>(ws->GetBlock(TL, BR));
+
+		int NCols = BR.GetCol() - TL.GetCol() + 1;
+
+		wxString TabStr;
+		for (size_t i = 0; i < Block->size(); ++i)
+		{
+			TabStr << (*Block)[i].GetValue();
+			TabStr << ((i + 1) % NCols == 0 ? "\n" : "\t");
+		}
 
 		wxDataObjectComposite* dataobj = new wxDataObjectComposite();
-		dataobj->Add(new XMLDataObject(XMLStr), true);
+		dataobj->Add(new BinaryDataObject(GenerateBinaryData(*Block)), true);
+		dataobj->Add(new LazyXMLDataObject(Block));
 		dataobj->Add(new wxTextDataObject(TabStr));
 
 		if (wxTheClipboard->Open())
 		{
+			//not flushed, flushing renders every format (see ~CWorkbookBase)
 			wxTheClipboard->SetData(dataobj);
-			wxTheClipboard->Flush();
 			wxTheClipboard->Close();
 		}
 
@@ -208,6 +299,116 @@ namespace grid
 
 
 
+	wxString GetTextData()
+	{
+		if (!wxTheClipboard->Open())
+			return wxEmptyString;
+
+		wxTextDataObject data;
+		if (wxTheClipboard->IsSupported(wxDF_TEXT))
+			wxTheClipboard->GetData(data);
+
+		wxTheClipboard->Close();
+
+		return data.GetText();
+	}
+
+
+	std::vector<Cell> TabStringToCells(
+		const wxString& str,
+		int RowPos,
+		int ColPos)
+	{
+		std::vector<Cell> Cells;
+
+		int row = RowPos;
+
+		wxStringTokenizer lines(str, "\n", wxTOKEN_RET_EMPTY);
+		while (lines.HasMoreTokens())
+		{
+			wxStringTokenizer columns(lines.GetNextToken(), '\t', wxTOKEN_RET_EMPTY);
+
+			int col = ColPos;
+			while (columns.HasMoreTokens())
+			{
+				Cell cell;
+				cell.SetRow(row);
+				cell.SetCol(col++);
+				cell.SetValue(columns.GetNextToken().ToStdWstring());
+
+				Cells.push_back(std::move(cell));
+			}
+
+			row++;
+		}
+
+		return Cells;
+	}
+
+
+
+
+
+	std::vector<Cell> TransposeCells(std::vector<Cell> Cells)
+	{
+		if (Cells.empty())
+			return Cells;
+
+		auto Corners = Cell::Get_TLBR(Cells);
+		int Row0 = Corners.first.GetRow(), Col0 = Corners.first.GetCol();
+
+		size_t NRows = (size_t)Corners.second.GetRow() - Row0 + 1;
+		size_t NCols = (size_t)Corners.second.GetCol() - Col0 + 1;
+
+		auto Swap = [Row0, Col0](Cell& cell)
+		{
+			int row = cell.GetRow() - Row0, col = cell.GetCol() - Col0;
+			cell.SetRow(Row0 + col);
+			cell.SetCol(Col0 + row);
+		};
+
+		//not a dense block (rows of text with unequal number of columns), swapping coordinates is enough
+		if (Cells.size() != NRows * NCols)
+		{
+			for (auto& cell : Cells)
+				Swap(cell);
+
+			return Cells;
+		}
+
+		//Walking tile by tile keeps both the source rows and the target rows in cache
+		constexpr size_t TILE = 32;
+
+		std::vector<Cell> Transposed(Cells.size());
+
+		for (size_t ii = 0; ii < NRows; ii += TILE)
+		{
+			size_t iEnd = std::min(ii + TILE, NRows);
+
+			for (size_t jj = 0; jj < NCols; jj += TILE)
+			{
+				size_t jEnd = std::min(jj + TILE, NCols);
+
+				for (size_t i = ii; i < iEnd; ++i)
+				{
+					for (size_t j = jj; j < jEnd; ++j)
+					{
+						Cell& cell = Cells[i * NCols + j];
+						Swap(cell);
+
+						Transposed[j * NRows + i] = std::move(cell);
+					}
+				}
+			}
+		}
+
+		return Transposed;
+	}
+
+
+
+
+
 	/*************************************************************** */
 
 
@@ -363,6 +564,25 @@ namespace grid
 	}
 
 
+	std::string GenerateXMLString(const std::vector<Cell>& Cells)
+	{
+		std::stringstream Str;
+		Str << "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n";
+
+		Str << "<WORKSHEET> \n";
+
+		for (const auto& cell : Cells)
+		{
+			wxString s = cell.ToXMLString();
+			Str << s.mb_str(wxConvUTF8) << "\n";
+		}
+
+		Str << "</WORKSHEET>";
+
+		return Str.str();
+	}
+
+
 	
 	std::string GenerateXMLString(CWorksheetBase* ws)
 	{
@@ -421,4 +641,245 @@ namespace grid
 	}
 
 
-}
\ No newline at end of file
+
+
+
+	/*************************************************************** */
+
+
+	std::string GenerateBinaryData(
+		const std::vector<Cell>& Cells,
+		bool Compress)
+	{
+		std::string Body;
+
+		wxGridCellCoords TL, BR;
+		if (!Cells.empty())
+			std::tie(TL, BR) = Cell::Get_TLBR(Cells);
+
+		int Row0 = std::max(TL.GetRow(), 0), Col0 = std::max(TL.GetCol(), 0);
+
+		WriteVarint(Body, Cells.size());
+		WriteVarint(Body, Row0);
+		WriteVarint(Body, Col0);
+		WriteVarint(Body, Cells.empty() ? 0 : BR.GetRow() - Row0 + 1);
+		WriteVarint(Body, Cells.empty() ? 0 : BR.GetCol() - Col0 + 1);
+
+		//Most blocks have a handful of distinct formats, therefore formats are written once to a table
+		std::unordered_map<std::string, size_t> StyleIndex;
+		std::vector<const std::string*> Styles;
+		std::vector<size_t> CellStyle;
+		CellStyle.reserve(Cells.size());
+
+		for (const auto& cell : Cells)
+		{
+			const auto& Format = cell.GetFormat();
+
+			std::string Style;
+			WriteVarint(Style, ColourToInt(Format.GetBackgroundColor()));
+			WriteVarint(Style, ColourToInt(Format.GetTextColor()));
+			WriteVarint(Style, (uint32_t)Format.GetHAlign());
+			WriteVarint(Style, (uint32_t)Format.GetVAlign());
+
+			auto Font = wxString(FonttoString(Format.GetFont())).utf8_str();
+			WriteBytes(Style, Font.data(), Font.length());
+
+			auto [it, Inserted] = StyleIndex.try_emplace(std::move(Style), Styles.size());
+			if (Inserted)
+				Styles.push_back(&it->first);
+
+			CellStyle.push_back(it->second);
+		}
+
+		WriteVarint(Body, Styles.size());
+		for (const auto Style : Styles)
+			Body += *Style;
+
+		for (size_t i = 0; i < Cells.size(); ++i)
+		{
+			const auto& cell = Cells[i];
+
+			WriteVarint(Body, cell.GetRow() - Row0);
+			WriteVarint(Body, cell.GetCol() - Col0);
+			WriteVarint(Body, CellStyle[i]);
+
+			auto Value = wxString(cell.GetValue()).utf8_str();
+			WriteBytes(Body, Value.data(), Value.length());
+		}
+
+		std::string Data(BINARY_MAGIC, 4);
+		
+		//small payloads are not worth compressing
+		std::string Compressed;
+		if (Compress && Body.size() > 1024)
+		{
+			wxMemoryOutputStream MemStream;
+			{
+				wxZlibOutputStream ZStream(MemStream, wxZ_BEST_SPEED, wxZLIB_ZLIB);
+				ZStream.Write(Body.data(), Body.size());
+				ZStream.Close();
+			}
+
+			Compressed.resize(MemStream.GetSize());
+			MemStream.CopyTo(Compressed.data(), Compressed.size());
+		}
+
+		bool IsCompressed = !Compressed.empty() && Compressed.size() < Body.size();
+
+		Data.push_back(IsCompressed ? 1 : 0);
+		WriteVarint(Data, Body.size());
+		Data += IsCompressed ? Compressed : Body;
+
+		return Data;
+	}
+
+
+
+	std::vector<Cell> BinaryDataToCells(
+		const void* Data,
+		size_t Length)
+	{
+		auto Bytes = (const unsigned char*)Data;
+
+		if (!Data || Length < 5 || memcmp(Bytes, BINARY_MAGIC, 4) != 0)
+			return {};
+
+		bool IsCompressed = (Bytes[4] & 1) != 0;
+
+		BinaryReader Header{ Bytes + 5, Bytes + Length };
+		uint64_t BodyLength = Header.Varint();
+		if (!Header.m_OK)
+			return {};
+
+		std::string Uncompressed;
+		BinaryReader Reader = Header;
+
+		//length comes from another process, zlib cannot expand data more than about 1032 times
+		uint64_t Remaining = uint64_t(Header.m_End - Header.m_Pos);
+		uint64_t MaxLength = IsCompressed ? Remaining * 1032 + 64 : Remaining;
+		if (BodyLength > MaxLength || BodyLength > MAX_BODYLENGTH)
+			return {};
+
+		if (IsCompressed)
+		{
+			Uncompressed.resize(BodyLength);
+
+			wxMemoryInputStream MemStream(Header.m_Pos, Header.m_End - Header.m_Pos);
+			wxZlibInputStream ZStream(MemStream, wxZLIB_ZLIB);
+			
+			if (!ZStream.ReadAll(Uncompressed.data(), Uncompressed.size()))
+				return {};
+
+			Reader = BinaryReader{ 
+				(const unsigned char*)Uncompressed.data(), 
+				(const unsigned char*)Uncompressed.data() + Uncompressed.size() };
+		}
+
+		uint64_t NCells = Reader.Varint();
+		int Row0 = (int)Reader.Varint();
+		int Col0 = (int)Reader.Varint();
+		Reader.Varint(); //NRows
+		Reader.Varint(); //NCols
+
+		uint64_t NStyles = Reader.Varint();
+		if (!Reader.m_OK || NStyles > BodyLength)
+			return {};
+
+		std::vector<CellFormat> Styles;
+		Styles.reserve(NStyles);
+
+		for (uint64_t i = 0; i < NStyles; ++i)
+		{
+			CellFormat Format;
+
+			uint64_t BGC = Reader.Varint(), FGC = Reader.Varint();
+
+			wxColour Color;
+			if (BGC > 0)
+			{
+				Color.SetRGBA(wxUint32(BGC - 1));
+				Format.SetBackgroundColor(Color);
+			}
+
+			if (FGC > 0)
+			{
+				Color.SetRGBA(wxUint32(FGC - 1));
+				Format.SetTextColor(Color);
+			}
+
+			int HAlign = (int)Reader.Varint();
+			int VAlign = (int)Reader.Varint();
+			Format.SetAlignment(HAlign, VAlign);
+
+			auto Font = Reader.Bytes();
+			Format.SetFont(StringtoFont(wxString::FromUTF8(Font.data(), Font.size())));
+
+			if (!Reader.m_OK)
+				return {};
+
+			Styles.push_back(Format);
+		}
+
+		//a cell takes at least 4 bytes (row, column, style and value length)
+		if (NCells > uint64_t(Reader.m_End - Reader.m_Pos) / 4)
+			return {};
+
+		std::vector<Cell> Cells;
+		Cells.reserve(NCells);
+
+		for (uint64_t i = 0; i < NCells; ++i)
+		{
+			int Row = Row0 + (int)Reader.Varint();
+			int Col = Col0 + (int)Reader.Varint();
+			uint64_t Style = Reader.Varint();
+			auto Value = Reader.Bytes();
+
+			if (!Reader.m_OK || Style >= Styles.size())
+				return {};
+
+			Cell cell;
+			cell.SetRow(Row);
+			cell.SetCol(Col);
+			cell.SetValue(wxString::FromUTF8(Value.data(), Value.size()).ToStdWstring());
+			cell.SetFormat(Styles[Style]);
+
+			Cells.push_back(std::move(cell));
+		}
+
+		return Cells;
+	}
+
+
+
+	std::vector<Cell> GetBinaryData()
+	{
+		if (!wxTheClipboard->Open())
+			return {};
+
+		std::vector<Cell> Cells;
+
+		if (wxTheClipboard->IsSupported(BinaryDataFormat()))
+		{
+			BinaryDataObject BinObj;
+			if (wxTheClipboard->GetData(BinObj))
+				Cells = BinaryDataToCells(BinObj.GetData(), BinObj.GetSize());
+		}
+
+		wxTheClipboard->Close();
+
+		return Cells;
+	}
+
+
+	bool SupportsBinary()
+	{
+		if (!wxTheClipboard->Open())
+			return false;
+
+		bool Supports = wxTheClipboard->IsSupported(BinaryDataFormat());
+		wxTheClipboard->Close();
+
+		return Supports;
+	}
+
+}
@@ -3,6 +3,8 @@
 #include <string>
 #include <tuple>
 #include <optional>
+#include <memory>
+#include <vector>
 
 #include <wx/wx.h>
 #include <wx/grid.h>
@@ -32,6 +34,23 @@ namespace grid
 	DLLGRID std::pair<wxGridCellCoords, wxGridCellCoords>
 		AddSelToClipbrd(const CWorksheetBase* ws);
 
+	//text (wxDF_TEXT) on the clipboard
+	DLLGRID wxString GetTextData();
+
+	//Cells (values only) from tab and newline separated text, first cell is at (RowPos, ColPos)
+	DLLGRID std::vector<Cell> TabStringToCells(
+		const wxString& str,
+		int RowPos = 0,
+		int ColPos = 0);
+
+	
+
+	/*
+		Rows become columns, the topleft of the block stays where it is.
+		Dense blocks are transposed tile by tile so that the result is in row-major order of the target.
+	*/
+	DLLGRID std::vector<Cell> TransposeCells(std::vector<Cell> Cells);
+
 	
 
 	/****************************************************** */
@@ -64,6 +83,9 @@ namespace grid
 	//UTF8 string
 	DLLGRID std::string GenerateXMLString(grid::CWorksheetBase* ws);
 
+	//UTF8 string of the cells (as given by CWorksheetBase::GetBlock)
+	DLLGRID std::string GenerateXMLString(const std::vector<Cell>& Cells);
+
 
 	//used by worksheet and others (probably they should not directly use it!)
 	struct XMLDataFormat : public wxDataFormat
@@ -81,4 +103,75 @@ namespace grid
 			SetFormat(XMLDataFormat());
 		}
 	};
+
+
+	//XML of the cells is only generated if a consumer asks for it
+	class LazyXMLDataObject : public XMLDataObject
+	{
+	public:
+		LazyXMLDataObject(std::shared_ptr<const std::vector<Cell>> Cells) :
+			m_Cells{ std::move(Cells) } {}
+
+		size_t GetTextLength() const override {
+			return GetText().length() + 1;
+		}
+
+		wxString GetText() const override
+		{
+			if (m_Cells)
+			{
+				m_XML = wxString::FromUTF8(GenerateXMLString(*m_Cells));
+				m_Cells.reset();
+			}
+
+			return m_XML;
+		}
+
+	private:
+		mutable std::shared_ptr<const std::vector<Cell>> m_Cells;
+		mutable wxString m_XML;
+	};
+
+
+
+	/****************************************************** */
+
+	/*
+		Compact binary encoding of cells:
+		header: "SSB1", flags (1: body is zlib compressed), length of the uncompressed body
+		body: number of cells, extent (TL, NRows, NCols), style table, then for every cell
+		its position relative to TL, style index and the length-prefixed UTF8 value
+	*/
+	DLLGRID std::string GenerateBinaryData(
+		const std::vector<Cell>& Cells,
+		bool Compress = true);
+
+	//empty if the data is malformed
+	DLLGRID std::vector<Cell> BinaryDataToCells(
+		const void* Data,
+		size_t Length);
+
+	//cells from the binary format on the clipboard
+	DLLGRID std::vector<Cell> GetBinaryData();
+
+	DLLGRID bool SupportsBinary();
+
+
+	//Preferred over XMLDataFormat when pasting, carries the same content
+	struct BinaryDataFormat : public wxDataFormat
+	{
+		BinaryDataFormat() : wxDataFormat("BinaryCellFormat") {}
+	};
+
+
+	class BinaryDataObject : public wxCustomDataObject
+	{
+	public:
+		BinaryDataObject(const std::string& Data = "") :
+			wxCustomDataObject(BinaryDataFormat())
+		{
+			if (!Data.empty())
+				SetData(Data.size(), Data.data());
+		}
+	};
 }
\ No newline at end of file
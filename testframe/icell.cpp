@@ -83,6 +83,11 @@ namespace ICELL
 					Paste(); 
 				}, Menu_Paste->GetId());
 
+				auto Menu_PasteTr = m_ContextMenu->Append(wxID_ANY, "Paste Transposed");
+				m_ContextMenu->Bind(wxEVT_MENU, [this](wxCommandEvent&) { 
+					Paste(true); 
+				}, Menu_PasteTr->GetId());
+
 				if (grid::SupportsXML()) {
 					auto PasteVal = m_ContextMenu->Append(wxID_ANY, "Paste Values");
 					auto PasteFrmt = m_ContextMenu->Append(wxID_ANY, "Paste Format");
@@ -97,6 +102,14 @@ namespace ICELL
 				}
 			}
 		}
+		else if (grid::SupportsXML() || wxTheClipboard->IsSupported(wxDF_TEXT))
+		{
+			m_ContextMenu->AppendSeparator();
+
+			auto Menu_PasteFill = m_ContextMenu->Append(wxID_ANY, "Paste Fill");
+			Menu_PasteFill->SetBitmap(wxArtProvider::GetBitmap(wxART_PASTE));
+			m_ContextMenu->Bind(wxEVT_MENU, [this](wxCommandEvent&) { PasteFill(); }, Menu_PasteFill->GetId());
+		}
 
 		PopupMenu(m_ContextMenu);
 		event.Skip();